@@ -72,6 +72,11 @@ void I_FatalError(const char* fmt, ...) ATTRIBUTE((format(printf, 1, 2)));
 // lots of potential for merge conflicts.
 
 int PrintString (int iprintlevel, const char *outline);
+
+// Diverts the calling thread's console output into the given string so that
+// worker threads don't print concurrently. Pass nullptr to print normally again.
+class FString;
+void C_SetPrintCapture(FString *capture);
 int VPrintf(int printlevel, const char* format, va_list parms);
 int Printf (int printlevel, const char *format, ...) ATTRIBUTE((format(printf,2,3)));
 int Printf (const char *format, ...) ATTRIBUTE((format(printf,1,2)));
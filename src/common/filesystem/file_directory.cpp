@@ -55,6 +55,7 @@ struct FDirectoryLump : public FResourceLump
 	int FillCache() override;
 
 	FString mFullPath;
+	FileReader Mapping;	// keeps the file mapped while the cache points into it.
 };
 
 
@@ -221,6 +222,7 @@ void FDirectory::AddEntry(const char *fullpath, int size)
 
 FileReader FDirectoryLump::NewReader()
 {
+	if (Mapping.isOpen()) return FResourceLump::NewReader();
 	FileReader fr;
 	fr.OpenFile(mFullPath);
 	return fr;
@@ -234,6 +236,18 @@ FileReader FDirectoryLump::NewReader()
 
 int FDirectoryLump::FillCache()
 {
+	// Larger files get mapped and stay that way, small ones are not worth spending a mapping on.
+	if (LumpSize >= 65536 && Mapping.OpenMapped(mFullPath))
+	{
+		if (Mapping.GetLength() >= LumpSize)
+		{
+			Cache = (char*)Mapping.GetBuffer();
+			RefCount = -1;
+			return -1;
+		}
+		Mapping.Close();
+	}
+
 	FileReader fr;
 	Cache = new char[LumpSize];
 	if (!fr.OpenFile(mFullPath))
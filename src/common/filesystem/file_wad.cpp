@@ -34,6 +34,7 @@
 */
 
 #include <ctype.h>
+#include <atomic>
 #include "resourcefile.h"
 #include "v_text.h"
 #include "filesystem.h"
@@ -404,7 +405,8 @@ void FWadFile::SetNamespace(const char *startmarker, const char *endmarker, name
 void FWadFile::SkinHack ()
 {
 	// this being static is not a problem. The only relevant thing is that each skin gets a different number.
-	static int namespc = ns_firstskin;
+	// Wads may be opened on multiple threads at once, though.
+	static std::atomic<int> namespc(ns_firstskin);
 	bool skinned = false;
 	bool hasmap = false;
 	uint32_t i;
@@ -421,11 +423,11 @@ void FWadFile::SkinHack ()
 				skinned = true;
 				uint32_t j;
 
+				int ns = namespc++;
 				for (j = 0; j < NumLumps; j++)
 				{
-					Lumps[j].Namespace = namespc;
+					Lumps[j].Namespace = ns;
 				}
-				namespc++;
 			}
 		}
 		if ((lump->getName()[0] == 'M' &&
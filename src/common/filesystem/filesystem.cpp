@@ -39,6 +39,8 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <thread>
+#include <vector>
 
 #include "m_argv.h"
 #include "cmdlib.h"
@@ -46,6 +48,9 @@
 #include "m_crc32.h"
 #include "printf.h"
 #include "md5.h"
+#include "templates.h"
+#include "i_time.h"
+#include "ctpl.h"
 
 extern	FILE* hashfile;
 
@@ -141,10 +146,29 @@ struct FileSystem::LumpRecord
 
 static void PrintLastError ();
 
+static bool CheckFileToAdd(const char *filename, FileReader &filereader, bool &isdir, bool quiet);
+static void OpenFilesInParallel(TArray<FString> &filenames, bool quiet, LumpFilterInfo* filter, std::vector<FPendingFile> &pending);
+
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
 FileSystem fileSystem;
 
+// PRIVATE DATA DEFINITIONS ------------------------------------------------
+
+static ctpl::thread_pool LoadPool;
+
+// A file being opened on the load pool.
+struct FPendingFile
+{
+	FileReader Reader;
+	FResourceFile *Resource = nullptr;
+	LumpFilterInfo Filter;	// private copy for the worker thread.
+	FString Messages;		// console output, printed when the file is added.
+	bool Found = false;
+	bool IsDir = false;
+	std::future<void> Job;
+};
+
 // CODE --------------------------------------------------------------------
 
 FileSystem::FileSystem()
@@ -200,16 +224,29 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 	// open all the files, load headers, and count lumps
 	DeleteAll();
 	numfiles = 0;
+	InitTimes = {};
+
+	uint64_t starttime = I_nsTime();
+	std::vector<FPendingFile> pending;
+	if (filenames.Size() > 1)
+	{
+		OpenFilesInParallel(filenames, quiet, filter, pending);
+	}
+	uint64_t mergetime = I_nsTime();
+	InitTimes.Open = (mergetime - starttime) / 1e6;
 
 	for(unsigned i=0;i<filenames.Size(); i++)
 	{
 		int baselump = NumEntries;
-		AddFile (filenames[i], nullptr, quiet, filter);
+		if (i < pending.size()) AddPendingFile(filenames[i], pending[i], quiet, filter);
+		else AddFile (filenames[i], nullptr, quiet, filter);
 		
 		if (i == (unsigned)MaxIwadIndex) MoveLumpsInFolder("after_iwad/");
 		FStringf path("filter/%s", Files.Last()->GetHash().GetChars());
 		MoveLumpsInFolder(path);
 	}
+	uint64_t posttime = I_nsTime();
+	InitTimes.Merge = (posttime - mergetime) / 1e6;
 	
 	NumEntries = FileInfo.Size();
 	if (NumEntries == 0)
@@ -218,9 +255,100 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 		else return;
 	}
 	if (filter && filter->postprocessFunc) filter->postprocessFunc();
+	uint64_t hashtime = I_nsTime();
+	InitTimes.PostProcess = (hashtime - posttime) / 1e6;
 
 	// [RH] Set up hash table
 	InitHashChains ();
+	InitTimes.Hash = (I_nsTime() - hashtime) / 1e6;
+}
+
+//==========================================================================
+//
+// OpenFilesInParallel
+//
+// Opening an archive and reading its directory is independent of all
+// other files so this gets done on a thread pool. The results are added
+// to the lump directory strictly in the original order afterward so
+// that overriding works exactly as if they had been opened one by one.
+// Directories are left to the main thread because scanning them is
+// not thread safe.
+//
+//==========================================================================
+
+static void CopyFilter(LumpFilterInfo &to, const LumpFilterInfo &from)
+{
+	// FStrings cannot be shared across threads so make real copies of everything.
+	for (auto &str : from.gameTypeFilter) to.gameTypeFilter.Push(FString(str.GetChars()));
+	for (auto &str : from.reservedFolders) to.reservedFolders.Push(FString(str.GetChars()));
+	for (auto &str : from.requiredPrefixes) to.requiredPrefixes.Push(FString(str.GetChars()));
+	to.dotFilter = from.dotFilter.GetChars();
+}
+
+static void OpenFilesInParallel(TArray<FString> &filenames, bool quiet, LumpFilterInfo* filter, std::vector<FPendingFile> &pending)
+{
+	if (LoadPool.size() == 0)
+	{
+		LoadPool.resize(clamp<int>(std::thread::hardware_concurrency(), 1, 8));
+	}
+
+	pending.resize(filenames.Size());
+	for (unsigned i = 0; i < filenames.Size(); i++)
+	{
+		auto &file = pending[i];
+		if (filter != nullptr)
+		{
+			CopyFilter(file.Filter, *filter);
+		}
+		const char *filename = filenames[i].GetChars();
+		file.Job = LoadPool.push([&file, filename, quiet, filter](int)
+		{
+			C_SetPrintCapture(&file.Messages);
+			try
+			{
+				file.Found = CheckFileToAdd(filename, file.Reader, file.IsDir, quiet);
+				if (file.Found && !file.IsDir)
+				{
+					file.Resource = FResourceFile::OpenResourceFile(filename, file.Reader, quiet, false, filter ? &file.Filter : nullptr);
+				}
+			}
+			catch (...)
+			{
+				C_SetPrintCapture(nullptr);
+				throw;
+			}
+			C_SetPrintCapture(nullptr);
+		});
+	}
+
+	// Everything must be finished before an error may be passed on.
+	for (auto &file : pending)
+	{
+		file.Job.wait();
+	}
+}
+
+//==========================================================================
+//
+// AddPendingFile
+//
+// Adds a file opened by OpenFilesInParallel, printing the same output
+// AddFile would have.
+//
+//==========================================================================
+
+void FileSystem::AddPendingFile(const char *filename, FPendingFile &file, bool quiet, LumpFilterInfo* filter)
+{
+	if (file.Found && !batchrun && !quiet) Printf (" adding %s", filename);
+	if (file.Messages.IsNotEmpty()) PrintString(PRINT_HIGH, file.Messages);
+	file.Job.get();	// rethrows any error that occured while opening.
+	if (!file.Found) return;
+
+	if (file.IsDir)
+	{
+		file.Resource = FResourceFile::OpenDirectory(filename, quiet, filter);
+	}
+	AddResourceFile(filename, file.Resource, file.Reader, quiet, filter);
 }
 
 //==========================================================================
@@ -280,42 +408,47 @@ int FileSystem::AddFromBuffer(const char* name, const char* type, char* data, in
 // [RH] Removed reload hack
 //==========================================================================
 
-void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, LumpFilterInfo* filter)
+static bool CheckFileToAdd(const char *filename, FileReader &filereader, bool &isdir, bool quiet)
 {
-	int startlump;
-	bool isdir = false;
-	FileReader filereader;
-
-	if (filer == nullptr)
+	// Does this exist? If so, is it a directory?
+	if (!DirEntryExists(filename, &isdir))
 	{
-		// Does this exist? If so, is it a directory?
-		if (!DirEntryExists(filename, &isdir))
+		if (!quiet)
 		{
+			Printf(TEXTCOLOR_RED "%s: File or Directory not found\n", filename);
+			PrintLastError();
+		}
+		return false;
+	}
+
+	if (!isdir)
+	{
+		// Mapped files let uncompressed lumps be used in place instead of being copied into the cache.
+		if (!filereader.OpenMapped(filename) && !filereader.OpenFile(filename))
+		{ // Didn't find file
 			if (!quiet)
 			{
-				Printf(TEXTCOLOR_RED "%s: File or Directory not found\n", filename);
+				Printf(TEXTCOLOR_RED "%s: File not found\n", filename);
 				PrintLastError();
 			}
-			return;
+			return false;
 		}
+	}
+	return true;
+}
 
-		if (!isdir)
-		{
-			if (!filereader.OpenFile(filename))
-			{ // Didn't find file
-				if (!quiet)
-				{
-					Printf(TEXTCOLOR_RED "%s: File not found\n", filename);
-					PrintLastError();
-				}
-				return;
-			}
-		}
+void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, LumpFilterInfo* filter)
+{
+	bool isdir = false;
+	FileReader filereader;
+
+	if (filer == nullptr)
+	{
+		if (!CheckFileToAdd(filename, filereader, isdir, quiet)) return;
 	}
 	else filereader = std::move(*filer);
 
 	if (!batchrun && !quiet) Printf (" adding %s", filename);
-	startlump = NumEntries;
 
 	FResourceFile *resfile;
 	
@@ -324,6 +457,19 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 	else
 		resfile = FResourceFile::OpenDirectory(filename, quiet, filter);
 
+	AddResourceFile(filename, resfile, filereader, quiet, filter);
+}
+
+//==========================================================================
+//
+// AddResourceFile
+//
+// Puts an opened resource file's lumps into the directory.
+//
+//==========================================================================
+
+void FileSystem::AddResourceFile(const char *filename, FResourceFile *resfile, FileReader &filereader, bool quiet, LumpFilterInfo* filter)
+{
 	if (resfile != NULL)
 	{
 		if (!quiet && !batchrun) Printf(", %d lumps\n", resfile->LumpCount());
@@ -850,26 +996,61 @@ void FileSystem::InitHashChains (void)
 	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
 
 
+	// Hashing the names does not depend on anything else so it can be spread
+	// across threads. The chains have to be linked in order, though.
+	TArray<uint32_t> keys(NumEntries * 3, true);
+	auto hashRange = [&](unsigned start, unsigned end)
+	{
+		for (unsigned k = start; k < end; k++)
+		{
+			auto &info = FileInfo[k];
+			keys[k * 3] = LumpNameHash(info.shortName.String) % NumEntries;
+			if (info.longName.IsNotEmpty())
+			{
+				const char *name = info.longName.GetChars();
+				size_t len = info.longName.Len();
+				auto dot = info.longName.LastIndexOf('.');
+				auto slash = info.longName.LastIndexOf('/');
+				keys[k * 3 + 1] = MakeKey(name, len) % NumEntries;
+				keys[k * 3 + 2] = MakeKey(name, dot > slash ? (size_t)dot : len) % NumEntries;
+			}
+		}
+	};
+
+	if (NumEntries >= 16384 && LoadPool.size() > 0)
+	{
+		const unsigned numslices = LoadPool.size() + 1;
+		const unsigned slicesize = (NumEntries + numslices - 1) / numslices;
+		std::vector<std::future<void>> jobs;
+		for (unsigned slice = 1; slice < numslices; slice++)
+		{
+			unsigned start = MIN(slice * slicesize, NumEntries);
+			unsigned end = MIN(start + slicesize, NumEntries);
+			jobs.push_back(LoadPool.push([&, start, end](int) { hashRange(start, end); }));
+		}
+		hashRange(0, MIN(slicesize, NumEntries));
+		for (auto &job : jobs) job.get();
+	}
+	else
+	{
+		hashRange(0, NumEntries);
+	}
+
 	// Now set up the chains
 	for (i = 0; i < (unsigned)NumEntries; i++)
 	{
-		j = LumpNameHash (FileInfo[i].shortName.String) % NumEntries;
+		j = keys[i * 3];
 		NextLumpIndex[i] = FirstLumpIndex[j];
 		FirstLumpIndex[j] = i;
 
 		// Do the same for the full paths
 		if (FileInfo[i].longName.IsNotEmpty())
 		{
-			j = MakeKey(FileInfo[i].longName) % NumEntries;
+			j = keys[i * 3 + 1];
 			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
 			FirstLumpIndex_FullName[j] = i;
 
-			FString nameNoExt = FileInfo[i].longName;
-			auto dot = nameNoExt.LastIndexOf('.');
-			auto slash = nameNoExt.LastIndexOf('/');
-			if (dot > slash) nameNoExt.Truncate(dot);
-
-			j = MakeKey(nameNoExt) % NumEntries;
+			j = keys[i * 3 + 2];
 			NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
 			FirstLumpIndex_NoExt[j] = i;
 
@@ -1422,6 +1603,36 @@ FileReader *FileSystem::GetFileReader(int rfnum)
 	return Files[rfnum]->GetReader();
 }
 
+//==========================================================================
+//
+// GetCacheStats
+//
+// Sums up the lump cache. Lumps whose cache points into a mapped or
+// in-memory archive are counted as views, they do not occupy any heap.
+//
+//==========================================================================
+
+void FileSystem::GetCacheStats(int &heaplumps, size_t &heapbytes, int &viewlumps, size_t &viewbytes) const
+{
+	heaplumps = viewlumps = 0;
+	heapbytes = viewbytes = 0;
+	for (auto &info : FileInfo)
+	{
+		auto lump = info.lump;
+		if (lump->Cache == nullptr) continue;
+		if (lump->RefCount < 0)
+		{
+			viewlumps++;
+			viewbytes += lump->LumpSize;
+		}
+		else
+		{
+			heaplumps++;
+			heapbytes += lump->LumpSize;
+		}
+	}
+}
+
 //==========================================================================
 //
 // GetResourceFileName
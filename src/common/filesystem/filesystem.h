@@ -17,6 +17,7 @@
 class FResourceFile;
 struct FResourceLump;
 class FTexture;
+struct FPendingFile;
 
 union LumpShortName
 {
@@ -67,6 +68,13 @@ public:
 	int GetMaxIwadNum() { return MaxIwadIndex; }
 	void SetMaxIwadNum(int x) { MaxIwadIndex = x; }
 
+	// How long the steps of the last InitMultipleFiles call took, in milliseconds.
+	struct FInitTimes
+	{
+		double Open, Merge, PostProcess, Hash;
+	};
+	FInitTimes InitTimes = {};
+
 	void InitSingleFile(const char *filename, bool quiet = false);
 	void InitMultipleFiles (TArray<FString> &filenames, bool quiet = false, LumpFilterInfo* filter = nullptr);
 	void AddFile (const char *filename, FileReader *wadinfo, bool quiet, LumpFilterInfo* filter);
@@ -186,6 +194,7 @@ public:
 	int AddExternalFile(const char *filename);
 	int AddFromBuffer(const char* name, const char* type, char* data, int size, int id, int flags);
 	FileReader* GetFileReader(int wadnum);	// Gets a FileReader object to the entire WAD
+	void GetCacheStats(int &heaplumps, size_t &heapbytes, int &viewlumps, size_t &viewbytes) const;
 	void InitHashChains();
 
 	// Blood stuff
@@ -230,6 +239,8 @@ protected:
 private:
 	void DeleteAll();
 	void MoveLumpsInFolder(const char *);
+	void AddResourceFile(const char *filename, FResourceFile *resfile, FileReader &filereader, bool quiet, LumpFilterInfo* filter);
+	void AddPendingFile(const char *filename, FPendingFile &file, bool quiet, LumpFilterInfo* filter);
 
 };
 
@@ -33,6 +33,18 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <mutex>
+#include <limits.h>
+
 #include "files.h"
 #include "templates.h"	// just for 'clamp'
 #include "zstring.h"
@@ -349,6 +361,153 @@ public:
 
 
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// maps an entire file into memory. Since this exposes a buffer, resource
+// files opened with it hand out views into the mapping as their lump cache
+// instead of reading each lump into a separate allocation.
+// The mapping is copy-on-write so that code which modifies a locked lump
+// only ever changes its own private copy of the affected pages.
+//
+//==========================================================================
+
+static bool FileMappingEnabled = true;
+static std::mutex MappedFilesLock;
+static TArray<class MappedFileReader *> MappedFiles;
+
+class MappedFileReader : public MemoryReader
+{
+public:
+	MappedFileReader()
+	{}
+
+	~MappedFileReader()
+	{
+		if (bufptr != nullptr)
+		{
+			{
+				std::lock_guard<std::mutex> lock(MappedFilesLock);
+				unsigned index = MappedFiles.Find(this);
+				if (index < MappedFiles.Size()) MappedFiles.Delete(index);
+			}
+#ifdef _WIN32
+			UnmapViewOfFile(bufptr);
+#else
+			munmap((void*)bufptr, Length);
+#endif
+			bufptr = nullptr;
+		}
+	}
+
+	bool Open(const char *filename)
+	{
+		// Large archives would eat up a 32 bit address space quickly.
+		if (sizeof(void*) < 8) return false;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileW(WideString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		void *view = nullptr;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.QuadPart <= LONG_MAX)
+		{
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping != nullptr)
+			{
+				view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				CloseHandle(mapping);	// the view keeps the mapping alive.
+			}
+		}
+		CloseHandle(file);
+		if (view == nullptr) return false;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		void *view = MAP_FAILED;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && info.st_size <= INT_MAX)
+		{
+			view = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		}
+		close(fd);	// the mapping does not need the descriptor.
+		if (view == MAP_FAILED) return false;
+		Length = (long)info.st_size;
+#endif
+		bufptr = (const char *)view;
+		FilePos = 0;
+
+		std::lock_guard<std::mutex> lock(MappedFilesLock);
+		MappedFiles.Push(this);
+		return true;
+	}
+
+	size_t Resident() const
+	{
+#ifdef _WIN32
+		return Length;	// not tracked, assume all of it.
+#else
+#ifdef __linux__
+		typedef unsigned char mincore_t;
+#else
+		typedef char mincore_t;
+#endif
+		size_t pagesize = sysconf(_SC_PAGESIZE);
+		size_t pages = (Length + pagesize - 1) / pagesize;
+		TArray<mincore_t> vec(pages, true);
+		if (mincore((void*)bufptr, Length, vec.Data()) != 0) return Length;
+
+		size_t resident = 0;
+		for (auto v : vec)
+		{
+			if (v & 1) resident++;
+		}
+		return MIN(resident * pagesize, (size_t)Length);
+#endif
+	}
+};
+
+//==========================================================================
+//
+// SetFileMapping
+//
+// Allows turning off memory mapping before any files get opened,
+// e.g. for file systems where mapping performs badly.
+//
+//==========================================================================
+
+void SetFileMapping(bool on)
+{
+	FileMappingEnabled = on;
+}
+
+//==========================================================================
+//
+// GetMappedFileStats
+//
+// Returns the number of mapped files, the address space they occupy and
+// how much of that is actually resident in memory. On Windows the resident
+// size is not queried and reported as the full mapping size.
+//
+//==========================================================================
+
+void GetMappedFileStats(int &count, size_t &mapped, size_t &resident)
+{
+	std::lock_guard<std::mutex> lock(MappedFilesLock);
+	count = MappedFiles.Size();
+	mapped = resident = 0;
+	for (auto file : MappedFiles)
+	{
+		mapped += file->GetLength();
+		resident += file->Resident();
+	}
+}
+
+
 //==========================================================================
 //
 // FileReader
@@ -370,6 +529,20 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenMapped(const char *filename)
+{
+	if (!FileMappingEnabled) return false;
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
@@ -168,6 +168,7 @@ public:
 	}
 
 	bool OpenFile(const char *filename, Size start = 0, Size length = -1);
+	bool OpenMapped(const char *filename);	// maps the entire file into memory, if supported. Fails for empty files.
 	bool OpenFilePart(FileReader &parent, Size start, Size length);
 	bool OpenMemory(const void *mem, Size length);	// read directly from the buffer
 	bool OpenMemoryArray(const void *mem, Size length);	// read from a copy of the buffer.
@@ -365,5 +366,8 @@ public:
 	TArray<unsigned char>&& TakeBuffer() { return std::move(mBuffer); }
 };
 
+void SetFileMapping(bool on);
+void GetMappedFileStats(int &count, size_t &mapped, size_t &resident);
+
 
 #endif
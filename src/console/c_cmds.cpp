@@ -863,6 +863,29 @@ CCMD (wdir)
 	}
 }
 
+//==========================================================================
+//
+// CCMD lumpmemory
+//
+// Shows how much memory the lump cache uses, split into heap allocations
+// and views into mapped archives, plus how much of the mapped archives
+// actually got paged in.
+//
+//==========================================================================
+
+CCMD (lumpmemory)
+{
+	int heaplumps, viewlumps, mappedfiles;
+	size_t heapbytes, viewbytes, mapped, resident;
+
+	fileSystem.GetCacheStats(heaplumps, heapbytes, viewlumps, viewbytes);
+	GetMappedFileStats(mappedfiles, mapped, resident);
+
+	Printf ("Cached lumps:  %d on heap, %zu KB\n", heaplumps, heapbytes / 1024);
+	Printf ("Mapped lumps:  %d in use, %zu KB\n", viewlumps, viewbytes / 1024);
+	Printf ("Mapped files:  %d, %zu KB mapped, %zu KB resident\n", mappedfiles, mapped / 1024, resident / 1024);
+}
+
 //-----------------------------------------------------------------------------
 //
 //
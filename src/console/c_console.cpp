@@ -888,6 +888,13 @@ void WriteLineToLog(FILE *LogFile, const char *outline)
 }
 
 
+static thread_local FString *PrintCapture;
+
+void C_SetPrintCapture(FString *capture)
+{
+	PrintCapture = capture;
+}
+
 int PrintString (int iprintlevel, const char *outline)
 {
 	int printlevel = iprintlevel & PRINT_TYPES;
@@ -895,6 +902,11 @@ int PrintString (int iprintlevel, const char *outline)
 	{
 		return 0;
 	}
+	if (PrintCapture != nullptr)
+	{
+		*PrintCapture += outline;
+		return (int)strlen(outline);
+	}
 	if (printlevel != PRINT_LOG || Logfile != nullptr)
 	{
 		// Convert everything coming through here to UTF-8 so that all console text is in a consistent format
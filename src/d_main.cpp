@@ -2782,6 +2782,8 @@ static int D_DoomMain_Internal (void)
 		Printf("\n");
 	}
 
+	SetFileMapping(!Args->CheckParm("-nommap"));
+
 	if (Args->CheckParm("-hashfiles"))
 	{
 		const char *filename = "fileinfo.txt";
@@ -2944,6 +2946,12 @@ static int D_DoomMain_Internal (void)
 		};
 
 		fileSystem.InitMultipleFiles (allwads, false, &lfi);
+		if (Args->CheckParm("-stdout"))
+		{
+			auto &times = fileSystem.InitTimes;
+			Printf("File system setup: %.1f ms opening archives, %.1f ms adding lumps, %.1f ms post processing, %.1f ms hashing\n",
+				times.Open, times.Merge, times.PostProcess, times.Hash);
+		}
 		allwads.Clear();
 		allwads.ShrinkToFit();
 		SetMapxxFlag();
@@ -3332,6 +3340,8 @@ int D_DoomMain()
 
 void D_Cleanup()
 {
+	G_FinishSaveGame(true);
+
 	if (demorecording)
 	{
 		G_CheckDemoStatus();
@@ -73,6 +73,8 @@
 #include "intermission/intermission.h"
 #include "g_levellocals.h"
 #include "events.h"
+#include "stats.h"
+#include "i_time.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -102,6 +104,9 @@
 #define GCSWEEPCOST		10
 #define GCFINALIZECOST	100
 
+// Number of single steps between clock checks in budgeted mode.
+#define GCBUDGETSTEPS	16
+
 // TYPES -------------------------------------------------------------------
 
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
@@ -116,6 +121,8 @@ extern DThinker *NextToThink;
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
+cycle_t GCTime;	// accumulated time of all collection steps
+
 namespace GC
 {
 size_t AllocBytes;
@@ -132,9 +139,17 @@ int StepMul = DEFAULT_GCMUL;
 int StepCount;
 size_t Dept;
 bool FinalGC;
+int TimeBudget;
+int PauseHistogram[NUM_PAUSEBUCKETS];
+uint64_t MaxPause;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
+static int BudgetTic = -1;		// tic TicTime was measured for
+static uint64_t TicTime;		// collection time spent in this tic, in nanoseconds
+
+const int PauseBucketLimits[NUM_PAUSEBUCKETS - 1] = { 50, 100, 250, 500, 1000, 2500, 5000 };
+
 // CODE --------------------------------------------------------------------
 
 //==========================================================================
@@ -389,47 +404,129 @@ static size_t SingleStep()
 	}
 }
 
+//==========================================================================
+//
+// RecordPause
+//
+// Sorts a pause into the histogram shown by 'stat gc'.
+//
+//==========================================================================
+
+static void RecordPause(uint64_t nsec)
+{
+	int usec = int(MIN<uint64_t>(nsec / 1000, INT_MAX));
+	int i = 0;
+	while (i < NUM_PAUSEBUCKETS - 1 && usec >= PauseBucketLimits[i]) i++;
+	PauseHistogram[i]++;
+	MaxPause = MAX(MaxPause, nsec);
+}
+
+//==========================================================================
+//
+// CheckTic
+//
+// Since the collector gets stepped from many places, its time is summed
+// up per tic, and that sum is what counts as one pause.
+//
+//==========================================================================
+
+static void CheckTic()
+{
+	if (gametic != BudgetTic)
+	{
+		if (TicTime > 0) RecordPause(TicTime);
+		TicTime = 0;
+		BudgetTic = gametic;
+	}
+}
+
 //==========================================================================
 //
 // Step
 //
 // Performs enough single steps to cover GCSTEPSIZE * StepMul% bytes of
-// memory.
+// memory. With a time budget set, it instead runs single steps until the
+// budget for the current tic is used up. If the budget turns out to be
+// too small to keep up with allocations and memory use reaches twice the
+// regular threshold, the budget is ignored until the collection finishes.
 //
 //==========================================================================
 
 void Step()
 {
-	size_t lim = (GCSTEPSIZE/100) * StepMul;
-	size_t olim;
-	if (lim == 0)
+	CheckTic();
+
+	uint64_t budget = uint64_t(TimeBudget) * 1000;
+	bool budgeted = budget > 0 && AllocBytes < (Estimate / 100) * Pause * 2;
+
+	if (budgeted && TicTime >= budget)
 	{
-		lim = (~(size_t)0) / 2;		// no limit
+		// Nothing left for this tic. Continue on the next one, but leave some
+		// headroom so that every allocation until then does not come back here.
+		Threshold = AllocBytes + GCSTEPSIZE;
+		return;
 	}
-	Dept += AllocBytes - Threshold;
-	do
-	{
-		olim = lim;
-		lim -= SingleStep();
-	} while (olim > lim && State != GCS_Pause);
-	if (State != GCS_Pause)
+
+	uint64_t start = I_nsTime();
+	GCTime.Clock();
+	if (budgeted)
 	{
-		if (Dept < GCSTEPSIZE)
+		// Always do at least one step. Step is normally entered while paused,
+		// and only the first step starts a new cycle by marking the roots.
+		do
 		{
-			Threshold = AllocBytes + GCSTEPSIZE;	// - lim/StepMul
+			int i = 0;
+			do
+			{
+				SingleStep();
+			} while (++i < GCBUDGETSTEPS && State != GCS_Pause);
+		} while (State != GCS_Pause && TicTime + (I_nsTime() - start) < budget);
+
+		if (State != GCS_Pause)
+		{
+			Dept = 0;
+			Threshold = AllocBytes + GCSTEPSIZE;
 		}
 		else
 		{
-			Dept -= GCSTEPSIZE;
-			Threshold = AllocBytes;
+			SetThreshold();
 		}
 	}
 	else
 	{
-		assert(AllocBytes >= Estimate);
-		SetThreshold();
+		size_t lim = (GCSTEPSIZE/100) * StepMul;
+		size_t olim;
+		if (lim == 0)
+		{
+			lim = (~(size_t)0) / 2;		// no limit
+		}
+		Dept += AllocBytes - Threshold;
+		do
+		{
+			olim = lim;
+			lim -= SingleStep();
+		} while (olim > lim && State != GCS_Pause);
+		if (State != GCS_Pause)
+		{
+			if (Dept < GCSTEPSIZE)
+			{
+				Threshold = AllocBytes + GCSTEPSIZE;	// - lim/StepMul
+			}
+			else
+			{
+				Dept -= GCSTEPSIZE;
+				Threshold = AllocBytes;
+			}
+		}
+		else
+		{
+			assert(AllocBytes >= Estimate);
+			SetThreshold();
+		}
 	}
 	StepCount++;
+	GCTime.Unclock();
+	TicTime += I_nsTime() - start;
 }
 
 //==========================================================================
@@ -442,6 +539,9 @@ void Step()
 
 void FullGC()
 {
+	CheckTic();
+	uint64_t start = I_nsTime();
+	GCTime.Clock();
 	if (State <= GCS_Propagate)
 	{
 		// Reset sweep mark to sweep all elements (returning them to white)
@@ -461,6 +561,8 @@ void FullGC()
 		SingleStep();
 	}
 	SetThreshold();
+	GCTime.Unclock();
+	TicTime += I_nsTime() - start;
 }
 
 //==========================================================================
@@ -607,6 +709,16 @@ ADD_STAT(gc)
 	{
 		out.AppendFormat("  %zuK", (GC::Dept + 1023) >> 10);
 	}
+	if (GC::TimeBudget > 0)
+	{
+		out.AppendFormat("  Budget: %dus", GC::TimeBudget);
+	}
+	out += "\nPauses:";
+	for (int i = 0; i < GC::NUM_PAUSEBUCKETS - 1; i++)
+	{
+		out.AppendFormat(" <%dus:%d", GC::PauseBucketLimits[i], GC::PauseHistogram[i]);
+	}
+	out.AppendFormat(" more:%d  Max: %.2fms", GC::PauseHistogram[GC::NUM_PAUSEBUCKETS - 1], GC::MaxPause / 1000000.);
 	return out;
 }
 
@@ -622,7 +734,7 @@ CCMD(gc)
 {
 	if (argv.argc() == 1)
 	{
-		Printf ("Usage: gc stop|now|full|count|pause [size]|stepmul [size]\n");
+		Printf ("Usage: gc stop|now|full|count|pause [size]|stepmul [size]|budget [usec]|resetpauses\n");
 		return;
 	}
 	if (stricmp(argv[1], "stop") == 0)
@@ -665,5 +777,21 @@ CCMD(gc)
 			GC::StepMul = MAX(100, atoi(argv[2]));
 		}
 	}
+	else if (stricmp(argv[1], "budget") == 0)
+	{
+		if (argv.argc() == 2)
+		{
+			Printf ("Current GC time budget is %dus per tic (0 = off)\n", GC::TimeBudget);
+		}
+		else
+		{
+			GC::TimeBudget = MAX(0, atoi(argv[2]));
+		}
+	}
+	else if (stricmp(argv[1], "resetpauses") == 0)
+	{
+		memset(GC::PauseHistogram, 0, sizeof(GC::PauseHistogram));
+		GC::MaxPause = 0;
+	}
 }
 
@@ -70,6 +70,15 @@ namespace GC
 	// Is this the final collection just before exit?
 	extern bool FinalGC;
 
+	// Maximum collection time per tic in microseconds. 0 leaves the step size to StepMul.
+	extern int TimeBudget;
+
+	// Histogram of the time spent collecting per tic.
+	enum { NUM_PAUSEBUCKETS = 8 };
+	extern const int PauseBucketLimits[NUM_PAUSEBUCKETS - 1];
+	extern int PauseHistogram[NUM_PAUSEBUCKETS];
+	extern uint64_t MaxPause;
+
 	// Current white value for known-dead objects.
 	static inline uint32_t OtherWhite()
 	{
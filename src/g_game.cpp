@@ -79,6 +79,7 @@
 #include "g_hub.h"
 #include "g_levellocals.h"
 #include "events.h"
+#include "ctpl.h"
 
 
 static FRandom pr_dmspawn ("DMSpawn");
@@ -103,13 +104,14 @@ void STAT_Serialize(FSerializer &file);
 bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompressedBuffer> &content);
 
 FIntCVar gameskill ("skill", 2, CVAR_SERVERINFO|CVAR_LATCH);
-CVAR(Bool, save_formatted, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use formatted JSON for saves (more readable but a larger files and a bit slower.
+CVAR(Bool, save_formatted, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use formatted JSON for saves instead of the binary format (readable but much larger and slower.)
 CVAR (Int, deathmatch, 0, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR (Bool, chasedemo, false, 0);
 CVAR (Bool, storesavepic, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (Bool, longsavemessages, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (String, save_dir, "", CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
 CVAR (Bool, cl_waitforsave, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR (Bool, save_background, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// compress and write savegames on a worker thread
 CVAR (Bool, enablescriptscreenshot, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 EXTERN_CVAR (Float, con_midtime);
 
@@ -1069,6 +1071,8 @@ void G_Ticker ()
 		AddCommandString ("toggle fullscreen");
 	}
 
+	G_FinishSaveGame(false);
+
 	// do things to change the game state
 	oldgamestate = gamestate;
 	while (gameaction != ga_nothing)
@@ -1224,7 +1228,9 @@ void G_Ticker ()
 	switch (gamestate)
 	{
 	case GS_LEVEL:
+		if (benchmarking) P_BenchmarkBeginTic();
 		P_Ticker ();
+		if (benchmarking) P_BenchmarkEndTic();
 		primaryLevel->automap->Ticker ();
 		break;
 
@@ -1883,6 +1889,9 @@ void G_DoLoadGame ()
 	hidecon = gameaction == ga_loadgamehidecon;
 	gameaction = ga_nothing;
 
+	// Make sure the file is complete if it is still being written.
+	G_FinishSaveGame(true);
+
 	std::unique_ptr<FResourceFile> resfile(FResourceFile::OpenResourceFile(savename.GetChars(), true, true));
 	if (resfile == nullptr)
 	{
@@ -2283,6 +2292,90 @@ static void PutSavePic (FileWriter *file, int width, int height)
 	}
 }
 
+//==========================================================================
+//
+// Everything about a savegame that can be done without accessing the
+// game state. G_DoSaveGame collects the data, this compresses it and
+// writes the file, normally on a worker thread.
+//
+//==========================================================================
+
+struct FSaveGameJob
+{
+	FString filename;
+	FString description;
+	bool okForQuicksave;
+	bool forceQuicksave;
+	TArray<FString> filenames;
+	TArray<FCompressedBuffer> content;	// owned by the job
+	bool succeeded = false;
+
+	~FSaveGameJob()
+	{
+		for (auto &buf : content) buf.Clean();
+	}
+
+	void Write()
+	{
+		// Everything but the savepic was left uncompressed by the game thread.
+		for (unsigned i = 1; i < content.Size(); i++)
+		{
+			if (content[i].mMethod == METHOD_STORED) CompressBuffer(content[i]);
+		}
+		succeeded = WriteZip(filename, filenames, content);
+	}
+};
+
+static ctpl::thread_pool SaveGamePool;
+static FSaveGameJob *PendingSave;
+static std::future<void> PendingSaveDone;
+
+//==========================================================================
+//
+// Reports the result of a savegame that was written in the background.
+// Unless 'wait' is set this does nothing while it is still being written.
+//
+//==========================================================================
+
+void G_FinishSaveGame (bool wait)
+{
+	if (PendingSave == nullptr) return;
+	if (PendingSaveDone.valid())
+	{
+		if (!wait && PendingSaveDone.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+		PendingSaveDone.get();
+	}
+
+	FSaveGameJob *job = PendingSave;
+	PendingSave = nullptr;
+
+	bool succeeded = false;
+	if (job->succeeded)
+	{
+		// Check whether the file is ok by trying to open it.
+		FResourceFile *test = FResourceFile::OpenResourceFile(job->filename, true);
+		if (test != nullptr)
+		{
+			delete test;
+			succeeded = true;
+		}
+	}
+
+	if (succeeded)
+	{
+		savegameManager.NotifyNewSave(job->filename, job->description, job->okForQuicksave, job->forceQuicksave);
+		BackupSaveName = job->filename;
+
+		if (longsavemessages) Printf("%s (%s)\n", GStrings("GGSAVED"), job->filename.GetChars());
+		else Printf("%s\n", GStrings("GGSAVED"));
+	}
+	else
+	{
+		Printf(PRINT_HIGH, "%s\n", GStrings("TXT_SAVEFAILED"));
+	}
+	delete job;
+}
+
 void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, const char *description)
 {
 	TArray<FCompressedBuffer> savegame_content;
@@ -2302,13 +2395,17 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 		filename = G_BuildSaveName ("demosave." SAVEGAME_EXT, -1);
 	}
 
+	// The previous save may still be writing, possibly to the same file.
+	G_FinishSaveGame(true);
+
 	if (cl_waitforsave)
 		I_FreezeTime(true);
 
 	insave = true;
 	try
 	{
-		level.SnapshotLevel();
+		// Compression is left to the save job.
+		level.SnapshotLevel(false);
 	}
 	catch(CRecoverableError &err)
 	{
@@ -2335,7 +2432,8 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	FSerializer savegameglobals(nullptr);	// and this for non-level related info that must be saved.
 
 	savegameinfo.OpenWriter(true);
-	savegameglobals.OpenWriter(save_formatted);
+	if (save_formatted) savegameglobals.OpenWriter(true);
+	else savegameglobals.OpenBinaryWriter();
 
 	SaveVersion = SAVEVER;
 	PutSavePic(&savepic, SAVEPICWIDTH, SAVEPICHEIGHT);
@@ -2381,55 +2479,58 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	}
 
 	auto picdata = savepic.GetBuffer();
-	FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->Size())), (char*)&(*picdata)[0] };
+	FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->Size())), new char[picdata->Size()] };
+	memcpy(bufpng.mBuffer, picdata->Data(), picdata->Size());
 
 	savegame_content.Push(bufpng);
 	savegame_filenames.Push("savepic.png");
-	savegame_content.Push(savegameinfo.GetCompressedOutput());
+	savegame_content.Push(savegameinfo.GetStoredOutput());
 	savegame_filenames.Push("info.json");
-	savegame_content.Push(savegameglobals.GetCompressedOutput());
+	savegame_content.Push(savegameglobals.GetStoredOutput());
 	savegame_filenames.Push("globals.json");
 
 	G_WriteSnapshots (savegame_filenames, savegame_content);
-	
 
-	bool succeeded = false;
-
-	if (WriteZip(filename, savegame_filenames, savegame_content))
+	// The job needs its own copy of everything because the game may continue
+	// while it is running. The current level's snapshot is not needed any
+	// longer so that one can be handed over. All others were already compressed.
+	auto job = new FSaveGameJob;
+	job->filename = filename;
+	job->description = description;
+	job->okForQuicksave = okForQuicksave;
+	job->forceQuicksave = forceQuicksave;
+	job->filenames = std::move(savegame_filenames);
+	for (unsigned i = 3; i < savegame_content.Size(); i++)
 	{
-		// Check whether the file is ok by trying to open it.
-		FResourceFile *test = FResourceFile::OpenResourceFile(filename, true);
-		if (test != nullptr)
+		auto &buf = savegame_content[i];
+		if (buf.mBuffer == level.info->Snapshot.mBuffer)
 		{
-			delete test;
-			succeeded = true;
+			level.info->Snapshot.mBuffer = nullptr;
+		}
+		else
+		{
+			char *copy = new char[buf.mCompressedSize];
+			memcpy(copy, buf.mBuffer, buf.mCompressedSize);
+			buf.mBuffer = copy;
 		}
 	}
+	job->content = std::move(savegame_content);
+	level.info->Snapshot.Clean();
 
-	if (succeeded)
-	{
-		savegameManager.NotifyNewSave(filename, description, okForQuicksave, forceQuicksave);
-		BackupSaveName = filename;
+	insave = false;
 
-		if (longsavemessages) Printf("%s (%s)\n", GStrings("GGSAVED"), filename.GetChars());
-		else Printf("%s\n", GStrings("GGSAVED"));
+	PendingSave = job;
+	if (save_background)
+	{
+		if (SaveGamePool.size() == 0) SaveGamePool.resize(1);
+		PendingSaveDone = SaveGamePool.push([job](int) { job->Write(); });
 	}
 	else
 	{
-		Printf(PRINT_HIGH, "%s\n", GStrings("TXT_SAVEFAILED"));
+		job->Write();
+		G_FinishSaveGame(true);
 	}
 
-
-	// delete the JSON buffers we created just above. Everything else will
-	// either still be needed or taken care of automatically.
-	savegame_content[1].Clean();
-	savegame_content[2].Clean();
-
-	// We don't need the snapshot any longer.
-	level.info->Snapshot.Clean();
-		
-	insave = false;
-
 	if (cl_waitforsave)
 		I_FreezeTime(false);
 }
@@ -2912,6 +3013,12 @@ void G_TimeDemo (const char* name)
 {
 	nodrawers = !!Args->CheckParm ("-nodraw");
 	noblit = !!Args->CheckParm ("-noblit");
+	if (Args->CheckParm("-benchmark"))
+	{
+		// Only the playsim is of interest here so don't waste any time on drawing.
+		nodrawers = noblit = true;
+		P_BenchmarkStart();
+	}
 	timingdemo = true;
 	singletics = true;
 
@@ -2966,6 +3073,7 @@ bool G_CheckDemoStatus (void)
 		{
 			if (timingdemo)
 			{
+				P_BenchmarkReport();
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
@@ -166,7 +166,7 @@ private:
 	void SerializeSounds(FSerializer &arc);
 
 public:
-	void SnapshotLevel();
+	void SnapshotLevel(bool compress = true);
 	void UnSnapshotLevel(bool hubLoad);
 
 	void FinalizePortals();
@@ -401,11 +401,20 @@ public:
 		if (rejectmatrix.Size() > 0)
 		{
 			int pnum = int(s1->Index()) * sectors.Size() + int(s2->Index());
-			return !(rejectmatrix[pnum >> 3] & (1 << (pnum & 7)));
+			if (rejectmatrix[pnum >> 3] & (1 << (pnum & 7))) return false;
 		}
 		return true;
 	}
 
+	// The generated reject. This must be checked separately from the map's reject table,
+	// because P_CheckSight may only use it after the RNG call for invisible targets.
+	bool CheckRejectGroups(sector_t *s1, sector_t *s2)
+	{
+		return rejectgroups.Size() == 0 || rejectgroups[s1->Index()] == rejectgroups[s2->Index()];
+	}
+
+	void BuildRejectGroups();
+
 	DThinker *CreateThinker(PClass *cls, int statnum = STAT_DEFAULT)
 	{
 		DThinker *thinker = static_cast<DThinker*>(cls->CreateNew());
@@ -440,7 +449,10 @@ public:
 	TArray<subsector_t> gamesubsectors;
 	TArray<node_t> gamenodes;
 	node_t *headgamenode;
+	FNodeGrid gamenodegrid;
+	FNodeGrid rendernodegrid;
 	TArray<uint8_t> rejectmatrix;
+	TArray<int> rejectgroups;	// generated reject: sectors in different groups can never see each other.
 	TArray<zone_t>	Zones;
 	TArray<FPolyObj> Polyobjects;
 
@@ -629,7 +641,7 @@ public:
 	uint32_t			ActiveParticles;
 	uint32_t			InactiveParticles;
 	TArray<particle_t>	Particles;
-	TArray<uint16_t>	ParticlesInSubsec;
+	TArray<uint32_t>	ParticlesInSubsec;
 	FThinkerCollection Thinkers;
 
 	TArray<DVector2>	Scrolls;		// NULL if no DScrollers in this level
@@ -4,6 +4,9 @@
 #include "doomtype.h"
 
 class AActor;
+struct node_t;
+struct subsector_t;
+struct vertex_t;
 
 // [RH] Like msecnode_t, but for the blockmap
 struct FBlockNode
@@ -96,4 +99,43 @@ struct FBlockmap
 
 };
 
+// Uniform grid over the map which stores for each cell the deepest BSP node
+// that still contains the entire cell, or the subsector if the cell lies
+// completely within one. Point lookups only need to descend the rest of
+// the tree from there, which gives the same result as a full walk.
+struct FNodeGrid
+{
+	enum
+	{
+		MINCELLSHIFT = 22,				// 64 map units
+		MAXCELLS = 1 << 18
+	};
+
+	TArray<void *>		cells;			// same encoding as node_t::children
+	int64_t				orgx = 0;
+	int64_t				orgy = 0;		// origin of the grid, in fixed point
+	unsigned			width = 0;
+	unsigned			height = 0;
+	int					shift = MINCELLSHIFT;	// cell size is 1 << shift fixed point units
+
+	void Build(node_t *headnode, const TArray<vertex_t> &vertexes);
+	static subsector_t *Descend(void *node, int x, int y);
+
+	inline void *GetStart(int x, int y, node_t *headnode) const
+	{
+		uint64_t cx = uint64_t(x - orgx) >> shift;
+		uint64_t cy = uint64_t(y - orgy) >> shift;
+		if (cx >= width || cy >= height) return headnode;
+		return cells[unsigned(cy) * width + unsigned(cx)];
+	}
+
+	void Clear()
+	{
+		cells.Reset();
+		width = height = 0;
+		orgx = orgy = 0;
+		shift = MINCELLSHIFT;
+	}
+};
+
 #endif
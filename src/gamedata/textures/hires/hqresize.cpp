@@ -44,6 +44,19 @@
 #include "xbr/xbrz_old.h"
 #include "parallel_for.h"
 #include "hwrenderer/textures/hw_material.h"
+#include "md5.h"
+#include "m_misc.h"
+#include "cmdlib.h"
+#include "files.h"
+#include <zlib.h>
+#include <time.h>
+#include <mutex>
+#include <algorithm>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 
 EXTERN_CVAR(Int, gl_texture_hqresizemult)
 CUSTOM_CVAR(Int, gl_texture_hqresizemode, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)
@@ -282,13 +295,7 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		HQnX_asm::InitLUTs();
-		initdone = true;
-	}
+	static bool initdone = (HQnX_asm::InitLUTs(), true);
 
 	HQnX_asm::CImage cImageIn;
 	cImageIn.SetImage(inputBuffer, inWidth, inHeight, 32);
@@ -309,13 +316,9 @@ static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*,
 							  int &outWidth,
 							  int &outHeight )
 {
-	static int initdone = false;
+	// Textures may be upscaled on multiple threads while precaching.
+	static bool initdone = (hqxInit(), true);
 
-	if (!initdone)
-	{
-		hqxInit();
-		initdone = true;
-	}
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
@@ -398,6 +401,224 @@ static void xbrzOldScale(size_t factor, const uint32_t* src, uint32_t* trg, int
 }
 
 
+//===========================================================================
+//
+// Upscale cache
+//
+// Keeps the upscaled buffers in the cache directory so that later runs do
+// not need to scale the same textures again. Entries are named after an
+// MD5 of the source pixels and the scaler settings and hold the zlib
+// compressed RGBA data. The file times serve as the last use for evicting
+// the oldest entries once the cache grows beyond its size limit.
+//
+//===========================================================================
+
+CVAR(Bool, gl_texture_hqresize_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CUSTOM_CVAR(Int, gl_texture_hqresize_cachesize, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 16) self = 16;
+}
+
+// Smaller textures get scaled faster than they can be looked up.
+enum { UPSCALE_CACHE_MINSIZE = 64 * 64 };
+static const char UpscaleCacheMagic[4] = { 'H', 'Q', 'C', '1' };
+
+struct FUpscaleCacheEntry
+{
+	size_t Size;
+	time_t Time;
+};
+
+// All of this may be accessed by the precache threads.
+static std::mutex UpscaleCacheLock;
+static TMap<FString, FUpscaleCacheEntry> UpscaleCache;
+static FString UpscaleCachePath;
+static size_t UpscaleCacheSize;
+static bool UpscaleCacheScanned;
+
+static void TouchFile(const char *path)
+{
+#ifdef _WIN32
+	_wutime(WideString(path).c_str(), nullptr);
+#else
+	utime(path, nullptr);
+#endif
+}
+
+// The following functions must be called with the lock held.
+static void ScanUpscaleCache()
+{
+	UpscaleCacheScanned = true;
+	UpscaleCachePath = M_GetCachePath(true);
+	UpscaleCachePath << "/upscale/";
+	CreatePath(UpscaleCachePath);
+
+	TArray<FFileList> list;
+	if (!ScanDirectory(list, UpscaleCachePath)) return;
+	for (auto &file : list)
+	{
+		FUpscaleCacheEntry entry;
+		if (!file.isDirectory && GetFileInfo(file.Filename, &entry.Size, &entry.Time))
+		{
+			UpscaleCache[ExtractFileBase(file.Filename)] = entry;
+			UpscaleCacheSize += entry.Size;
+		}
+	}
+}
+
+static FString UpscaleCacheFile(const FString &key)
+{
+	FString path = UpscaleCachePath.GetChars();
+	path << key << ".hqc";
+	return path;
+}
+
+static void RemoveUpscaleCacheEntry(const FString &key)
+{
+	auto entry = UpscaleCache.CheckKey(key);
+	if (entry != nullptr)
+	{
+		UpscaleCacheSize -= entry->Size;
+		UpscaleCache.Remove(key);
+	}
+	remove(UpscaleCacheFile(key));
+}
+
+static void EvictUpscaleCache()
+{
+	size_t limit = size_t(gl_texture_hqresize_cachesize) << 20;
+	if (UpscaleCacheSize <= limit) return;
+
+	// Go down to 3/4 of the limit so that this doesn't run for each new entry.
+	TArray<TMap<FString, FUpscaleCacheEntry>::Pair *> entries;
+	TMap<FString, FUpscaleCacheEntry>::Iterator it(UpscaleCache);
+	TMap<FString, FUpscaleCacheEntry>::Pair *pair;
+	while (it.NextPair(pair)) entries.Push(pair);
+	std::sort(entries.begin(), entries.end(), [](auto a, auto b) { return a->Value.Time < b->Value.Time; });
+
+	TArray<FString> removed;
+	for (auto entry : entries)
+	{
+		if (UpscaleCacheSize <= limit / 4 * 3) break;
+		removed.Push(entry->Key);
+		UpscaleCacheSize -= entry->Value.Size;
+	}
+	for (auto &key : removed)
+	{
+		UpscaleCache.Remove(key);
+		remove(UpscaleCacheFile(key));
+	}
+}
+
+static FString UpscaleCacheKey(const unsigned char *buffer, int width, int height, int type, int mult)
+{
+	MD5Context md5;
+	int params[4] = { width, height, type, mult };
+	md5.Update((const uint8_t *)params, sizeof(params));
+	if (type == 4 || type == 5)
+	{
+		float cfg[5] = { xbrz_luminanceweight, xbrz_equalcolortolerance, xbrz_centerdirectionbias, xbrz_dominantdirectionthreshold, xbrz_steepdirectionthreshold };
+		md5.Update((const uint8_t *)cfg, sizeof(cfg));
+	}
+	md5.Update(buffer, width * height * 4);
+
+	uint8_t digest[16];
+	md5.Final(digest);
+	FString key;
+	for (auto b : digest) key.AppendFormat("%02x", b);
+	return key;
+}
+
+static unsigned char *LoadUpscaledBuffer(const FString &key, int width, int height)
+{
+	FString path;
+	{
+		std::lock_guard<std::mutex> lock(UpscaleCacheLock);
+		if (!UpscaleCacheScanned) ScanUpscaleCache();
+		if (UpscaleCache.CheckKey(key) == nullptr) return nullptr;
+		path = UpscaleCacheFile(key);
+	}
+
+	// Entries never get overwritten so the file can be read without the lock.
+	FileReader fr;
+	TArray<uint8_t> filedata;
+	const uint8_t *data = nullptr;
+	long length = 0;
+	if (fr.OpenMapped(path))
+	{
+		data = (const uint8_t *)fr.GetBuffer();
+		length = (long)fr.GetLength();
+	}
+	else if (fr.OpenFile(path))
+	{
+		length = (long)fr.GetLength();
+		filedata.Resize(length);
+		if (fr.Read(filedata.Data(), length) == length) data = filedata.Data();
+	}
+
+	unsigned char *buffer = nullptr;
+	if (data != nullptr && length > 12 && !memcmp(data, UpscaleCacheMagic, 4) &&
+		LittleLong(*(const uint32_t *)(data + 4)) == uint32_t(width) && LittleLong(*(const uint32_t *)(data + 8)) == uint32_t(height))
+	{
+		uLongf outlen = width * height * 4;
+		buffer = new unsigned char[outlen];
+		if (uncompress(buffer, &outlen, data + 12, length - 12) != Z_OK || outlen != uLongf(width * height * 4))
+		{
+			delete[] buffer;
+			buffer = nullptr;
+		}
+	}
+	fr.Close();
+
+	std::lock_guard<std::mutex> lock(UpscaleCacheLock);
+	if (buffer == nullptr)
+	{
+		// Missing or damaged, so get rid of it.
+		RemoveUpscaleCacheEntry(key);
+		return nullptr;
+	}
+	auto entry = UpscaleCache.CheckKey(key);
+	if (entry != nullptr) entry->Time = time(nullptr);
+	TouchFile(path);
+	return buffer;
+}
+
+static void StoreUpscaledBuffer(const FString &key, const unsigned char *buffer, int width, int height)
+{
+	uLong srclen = width * height * 4;
+	uLongf outlen = compressBound(srclen);
+	TArray<Bytef> compressed;
+	compressed.Resize(outlen + 12);
+	if (compress2(compressed.Data() + 12, &outlen, buffer, srclen, Z_BEST_SPEED) != Z_OK) return;
+
+	uint32_t size[2] = { LittleLong(uint32_t(width)), LittleLong(uint32_t(height)) };
+	memcpy(compressed.Data(), UpscaleCacheMagic, 4);
+	memcpy(compressed.Data() + 4, size, 8);
+	size_t length = outlen + 12;
+
+	std::lock_guard<std::mutex> lock(UpscaleCacheLock);
+	if (!UpscaleCacheScanned) ScanUpscaleCache();
+	if (UpscaleCache.CheckKey(key) != nullptr) return;
+
+	FString path = UpscaleCacheFile(key);
+	FileWriter *fw = FileWriter::Open(path);
+	if (fw == nullptr) return;
+	bool success = fw->Write(compressed.Data(), length) == length;
+	delete fw;
+	if (!success)
+	{
+		remove(path);
+		return;
+	}
+
+	// Don't share the string buffer with the caller's copy which lives on another thread.
+	auto &entry = UpscaleCache[FString(key.GetChars())];
+	entry.Size = length;
+	entry.Time = time(nullptr);
+	UpscaleCacheSize += length;
+	EvictUpscaleCache();
+}
+
 //===========================================================================
 // 
 // [BB] Upsamples the texture in texbuffer.mBuffer, frees texbuffer.mBuffer and returns
@@ -455,7 +676,22 @@ void FTexture::CreateUpsampledTextureBuffer(FTextureBuffer &texbuffer, bool hasA
 
 	if (!checkonly)
 	{
-		if (type == 1)
+		FString cachekey;
+		unsigned char *cached = nullptr;
+		if (gl_texture_hqresize_cache && inWidth * inHeight >= UPSCALE_CACHE_MINSIZE)
+		{
+			cachekey = UpscaleCacheKey(texbuffer.mBuffer, inWidth, inHeight, type, mult);
+			cached = LoadUpscaledBuffer(cachekey, mult * inWidth, mult * inHeight);
+		}
+
+		if (cached != nullptr)
+		{
+			delete[] texbuffer.mBuffer;
+			texbuffer.mBuffer = cached;
+			texbuffer.mWidth = mult * inWidth;
+			texbuffer.mHeight = mult * inHeight;
+		}
+		else if (type == 1)
 		{
 			if (mult == 2)
 				texbuffer.mBuffer = scaleNxHelper(&scale2x, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
@@ -495,6 +731,11 @@ void FTexture::CreateUpsampledTextureBuffer(FTextureBuffer &texbuffer, bool hasA
 			texbuffer.mBuffer = normalNx(mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
 		else
 			return;
+
+		if (cached == nullptr && cachekey.IsNotEmpty())
+		{
+			StoreUpscaledBuffer(cachekey, texbuffer.mBuffer, texbuffer.mWidth, texbuffer.mHeight);
+		}
 	}
 	else
 	{
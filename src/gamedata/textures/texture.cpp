@@ -676,6 +676,38 @@ bool FTexture::ProcessData(unsigned char * buffer, int w, int h, bool ispatch)
 	return true;
 }
 
+//===========================================================================
+// 
+// Buffers that were created ahead of time, e.g. by the precacher which
+// does the postprocessing on multiple threads. The next CreateTexBuffer
+// call with matching parameters takes them over.
+//
+//===========================================================================
+
+struct FPreparedTexBuffer
+{
+	FTexture *Texture;
+	int Translation;
+	int Flags;
+	FTextureBuffer Buffer;
+};
+
+static TArray<FPreparedTexBuffer> PreparedTexBuffers;
+
+void FTexture::AddPreparedTexBuffer(FTexture *tex, int translation, int flags, FTextureBuffer &&buffer)
+{
+	auto &entry = PreparedTexBuffers[PreparedTexBuffers.Reserve(1)];
+	entry.Texture = tex;
+	entry.Translation = translation;
+	entry.Flags = flags;
+	entry.Buffer = std::move(buffer);
+}
+
+void FTexture::FlushPreparedTexBuffers()
+{
+	PreparedTexBuffers.Clear();
+}
+
 //===========================================================================
 // 
 //	Initializes the buffer for the texture data
@@ -683,12 +715,41 @@ bool FTexture::ProcessData(unsigned char * buffer, int w, int h, bool ispatch)
 //===========================================================================
 
 FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
+{
+	if (PreparedTexBuffers.Size() > 0 && !(flags & CTF_CheckOnly))
+	{
+		unsigned index = PreparedTexBuffers.FindEx([=](const FPreparedTexBuffer &entry)
+		{
+			return entry.Texture == this && entry.Translation == translation && entry.Flags == flags;
+		});
+		if (index < PreparedTexBuffers.Size())
+		{
+			FTextureBuffer result = std::move(PreparedTexBuffers[index].Buffer);
+			PreparedTexBuffers.Delete(index);
+			return result;
+		}
+	}
+
+	int isTransparent;
+	FTextureBuffer result = CreateRawTexBuffer(translation, flags, isTransparent);
+	PostProcessTexBuffer(result, isTransparent, flags);
+	return result;
+}
+
+//===========================================================================
+// 
+//	Creates the unprocessed texture data. This accesses the file system
+//	and the image caches so it must be called from the main thread.
+//
+//===========================================================================
+
+FTextureBuffer FTexture::CreateRawTexBuffer(int translation, int flags, int &isTransparent)
 {
 	FTextureBuffer result;
 
 	unsigned char * buffer = nullptr;
 	int W, H;
-	int isTransparent = -1;
+	isTransparent = -1;
 	bool checkonly = !!(flags & CTF_CheckOnly);
 
 	int exx = !!(flags & CTF_Expand);
@@ -734,6 +795,20 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 	result.mBuffer = buffer;
 	result.mWidth = W;
 	result.mHeight = H;
+	return result;
+}
+
+//===========================================================================
+// 
+//	Upscales and postprocesses the texture data. This only works on the
+//	buffer and this texture's own fields, so different textures may be
+//	processed on different threads at the same time.
+//
+//===========================================================================
+
+void FTexture::PostProcessTexBuffer(FTextureBuffer &result, int isTransparent, int flags)
+{
+	bool checkonly = !!(flags & CTF_CheckOnly);
 
 	// Only do postprocessing for image-backed textures. (i.e. not for the burn texture which can also pass through here.)
 	if (GetImage() && flags & CTF_ProcessData) 
@@ -741,8 +816,6 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 		CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
 		if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
 	}
-
-	return result;
 }
 
 //===========================================================================
@@ -751,11 +824,18 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 //
 //===========================================================================
 
+std::recursive_mutex FTexture::SetupMutex;
+
 bool FTexture::GetTranslucency()
 {
 	if (bTranslucent == -1)
 	{
-		if (!bHasCanvas)
+		std::lock_guard<std::recursive_mutex> lock(SetupMutex);
+		if (bTranslucent != -1)
+		{
+			// another thread got here first.
+		}
+		else if (!bHasCanvas)
 		{
 			// This will calculate all we need, so just discard the result.
 			CreateTexBuffer(0);
@@ -44,6 +44,7 @@
 #include "r_data/r_translate.h"
 #include "hwrenderer/textures/hw_texcontainer.h"
 #include <vector>
+#include <mutex>
 
 // 15 because 0th texture is our texture
 #define MAX_CUSTOM_HW_SHADER_TEXTURES 15
@@ -496,8 +497,15 @@ protected:
 
 public:
 	FTextureBuffer CreateTexBuffer(int translation, int flags = 0);
+	FTextureBuffer CreateRawTexBuffer(int translation, int flags, int &isTransparent);
+	void PostProcessTexBuffer(FTextureBuffer &buffer, int isTransparent, int flags);
+	static void AddPreparedTexBuffer(FTexture *tex, int translation, int flags, FTextureBuffer &&buffer);
+	static void FlushPreparedTexBuffers();
 	bool GetTranslucency();
 
+	// Serializes the lazy setup of textures and materials when the hardware renderer's BSP workers run in parallel.
+	static std::recursive_mutex SetupMutex;
+
 private:
 	int CheckDDPK3();
 	int CheckExternalFile(bool & hascolorkey);
@@ -521,7 +529,7 @@ class FxAddSub;
 // Texture manager
 class FTextureManager
 {
-	friend class FxAddSub;	// needs access to do a bounds check on the texture ID.
+	friend void *GetTextureCountAddress();	// needs access to do a bounds check on the texture ID.
 public:
 	FTextureManager ();
 	~FTextureManager ();
@@ -3205,6 +3205,8 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 
 	// Create the item indices, after the last function which may change the data has run.
 	CalcIndices();
+	Level->gamenodegrid.Build(Level->headgamenode, Level->vertexes);
+	Level->rendernodegrid.Build(Level->HeadNode(), Level->vertexes);
 
 	Level->bodyqueslot = 0;
 	// phares 8/10/98: Clear body queue so the corpses from previous games are
@@ -3257,7 +3259,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 
 	InitRenderInfo();				// create hardware independent renderer resources for the level. This must be done BEFORE the PolyObj Spawn!!!
 	Level->ClearDynamic3DFloorData();	// CreateVBO must be run on the plain 3D floor data.
-	screen->mVertexData->CreateVBO(Level->sectors);
+	if (screen->mVertexData != nullptr) screen->mVertexData->CreateVBO(Level->sectors);	// the null framebuffer has none.
 
 	for (auto &sec : Level->sectors)
 	{
@@ -3272,5 +3274,6 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	PO_Init();				// Initialize the polyobjs
 	if (!Level->IsReentering())
 		Level->FinalizePortals();	// finalize line portals after polyobjects have been initialized. This info is needed for properly flagging them.
+	Level->BuildRejectGroups();
 }
 
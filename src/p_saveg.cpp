@@ -1049,6 +1049,7 @@ void FLevelLocals::Serialize(FSerializer &arc, bool hubload)
 		localEventManager->SetOwnerForHandlers();	// This cannot be automated.
 		RecreateAllAttachedLights();
 		InitPortalGroups(this);
+		BuildRejectGroups();	// portal destinations may have been changed by the savegame.
 
 		auto it = GetThinkerIterator<DImpactDecal>(NAME_None, STAT_AUTODECAL);
 		ImpactDecalCount = 0;
@@ -1063,10 +1064,11 @@ void FLevelLocals::Serialize(FSerializer &arc, bool hubload)
 //==========================================================================
 //
 // Archives the current level
+// Without compression the caller has to take care of that.
 //
 //==========================================================================
 
-void FLevelLocals::SnapshotLevel()
+void FLevelLocals::SnapshotLevel(bool compress)
 {
 	info->Snapshot.Clean();
 
@@ -1074,11 +1076,12 @@ void FLevelLocals::SnapshotLevel()
 	{
 		FSerializer arc(this);
 
-		if (arc.OpenWriter(save_formatted))
+		// Snapshots are only written as JSON when they are supposed to be human readable.
+		if (save_formatted ? arc.OpenWriter(true) : arc.OpenBinaryWriter())
 		{
 			SaveVersion = SAVEVER;
 			Serialize(arc, false);
-			info->Snapshot = arc.GetCompressedOutput();
+			info->Snapshot = compress ? arc.GetCompressedOutput() : arc.GetStoredOutput();
 		}
 	}
 }
@@ -332,7 +332,10 @@ void FLevelLocals::ClearLevelData()
 	gamenodes.Reset();
 	subsectors.Clear();
 	gamesubsectors.Reset();
+	gamenodegrid.Clear();
+	rendernodegrid.Clear();
 	rejectmatrix.Clear();
+	rejectgroups.Clear();
 	Zones.Clear();
 	blockmap.Clear();
 	Polyobjects.Clear();
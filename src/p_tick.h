@@ -7,5 +7,12 @@
 void P_Ticker (void);
 bool P_CheckTickerPaused ();
 
+// Playsim benchmark, enabled with -benchmark while timing a demo.
+extern bool benchmarking;
+void P_BenchmarkStart();
+void P_BenchmarkBeginTic();
+void P_BenchmarkEndTic();
+void P_BenchmarkReport();
+
 
 #endif
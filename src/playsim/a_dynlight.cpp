@@ -64,10 +64,19 @@
 #include "a_dynlight.h"
 #include "actorinlines.h"
 #include "memarena.h"
+#include "ctpl.h"
+#include "stats.h"
 
 static FMemArena DynLightArena(sizeof(FDynamicLight) * 200);
 static TArray<FDynamicLight*> FreeList;
 static FRandom randLight;
+static TArray<FDynamicLight *> *PendingLinks;	// set while TickDynamicLights defers relinking
+
+// Lights are linked with this much extra radius so that small movements
+// within the same section do not require a relink.
+CVAR(Int, r_lightrelinkdistance, 16, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+static unsigned LightRelinks, LightRelinksSkipped, LightNodesLinked, LightNodesUnlinked;
 
 extern TArray<FLightDefaults *> StateLights;
 
@@ -407,11 +416,34 @@ void FDynamicLight::UpdateLocation()
 		if (X() != oldx || Y() != oldy || radius != oldradius)
 		{
 			//Update the light lists
-			LinkLight();
+			if (!NeedsRelink()) LightRelinksSkipped++;
+			else if (PendingLinks != nullptr) PendingLinks->Push(this);
+			else LinkLight();
 		}
 	}
 }
 
+//==========================================================================
+//
+// The links are only made for the light's last linked position, with some
+// extra radius. As long as the light stays in the same section and within
+// that extra radius, everything it can reach is still linked.
+//
+//==========================================================================
+
+bool FDynamicLight::NeedsRelink() const
+{
+	if (linkSection == nullptr || radius != linkRadius || linkSlack != float(MAX(0, *r_lightrelinkdistance)))
+	{
+		return true;
+	}
+	if ((Pos - linkPos).LengthSquared() > double(linkSlack) * linkSlack)
+	{
+		return true;
+	}
+	return Level->PointInRenderSubsector(Pos)->section != linkSection;
+}
+
 //=============================================================================
 //
 // These have been copied from the secnode code and modified for the light links
@@ -442,6 +474,7 @@ FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * l
 	// of the list.
 	
 	node = new FLightNode;
+	LightNodesLinked++;
 	
 	node->targ = linkto;
 	node->lightsource = light; 
@@ -485,6 +518,7 @@ static FLightNode * DeleteLightNode(FLightNode * node)
 		// Return this node to the freelist
 		tn=node->nextTarget;
 		delete node;
+		LightNodesUnlinked++;
 		return(tn);
 	}
 	return(nullptr);
@@ -522,45 +556,126 @@ double FDynamicLight::DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *
 
 //==========================================================================
 //
-// Collect all touched sidedefs and subsectors
-// to sidedefs and sector parts.
+// Per-thread visit marks for the light link collection.
+// These replace the validcount checks so that several lights can be
+// collected at once without writing to any shared level data.
 //
 //==========================================================================
+
 struct LightLinkEntry
 {
 	FSection *sect;
 	DVector3 pos;
 };
-static TArray<LightLinkEntry> collected_ss;
 
-void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section, float radius)
+struct FLightLinkMarks
+{
+	TArray<int> sectionmarks;
+	TArray<int> linemarks;
+	TArray<LightLinkEntry> collected;
+	int stamp = 0;
+
+	void Begin(FLevelLocals *Level)
+	{
+		unsigned numsections = Level->sections.allSections.Size();
+		unsigned numlines = Level->lines.Size();
+		if (sectionmarks.Size() != numsections || linemarks.Size() != numlines || stamp == INT_MAX)
+		{
+			sectionmarks.Resize(numsections);
+			linemarks.Resize(numlines);
+			memset(sectionmarks.Data(), 0, numsections * sizeof(int));
+			memset(linemarks.Data(), 0, numlines * sizeof(int));
+			stamp = 0;
+		}
+		stamp++;
+	}
+
+	bool MarkSection(FLevelLocals *Level, FSection *sect)
+	{
+		int &mark = sectionmarks[unsigned(sect - Level->sections.allSections.Data())];
+		if (mark == stamp) return false;
+		mark = stamp;
+		return true;
+	}
+
+	bool LineMarked(line_t *line) const
+	{
+		return linemarks[line->Index()] == stamp;
+	}
+
+	void MarkLine(line_t *line)
+	{
+		linemarks[line->Index()] = stamp;
+	}
+};
+
+//==========================================================================
+//
+// The sections and sides a light touches, in the order they were found.
+//
+//==========================================================================
+
+struct FLightLinkSet
+{
+	TArray<FSection *> sections;
+	TArray<side_t *> sides;
+	FSection *section;		// the section the light is in
+	float slack;			// the extra radius the links were collected with
+	bool shadowmapped;
+};
+
+//==========================================================================
+//
+// Collect all touched sidedefs and subsectors
+// to sidedefs and sector parts.
+//
+//==========================================================================
+
+void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section, float radius, FLightLinkMarks &marks, FLightLinkSet &set) const
 {
 	if (!section) return;
+	auto &collected_ss = marks.collected;
 	collected_ss.Clear();
 	collected_ss.Push({ section, opos });
-	section->validcount = dl_validcount;
+	marks.MarkSection(Level, section);
 
 	bool hitonesidedback = false;
+	const double range = sqrt(radius);
 	for (unsigned i = 0; i < collected_ss.Size(); i++)
 	{
 		auto pos = collected_ss[i].pos;
 		section = collected_ss[i].sect;
 
-		touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
+		set.sections.Push(section);
+
+		// Compare the section's bounding circle with the light first. If it is completely
+		// inside or outside the light, the distance to its lines does not need to be checked.
+		// The margin of one map unit keeps rounding errors from changing the result.
+		double centerdist = (section->center - pos.XY()).Length();
+		bool allinside = centerdist + section->boundradius + 1 <= range;
+		bool alloutside = centerdist - section->boundradius - 1 > range;
 
 
 		auto processSide = [&](side_t *sidedef, const vertex_t *v1, const vertex_t *v2)
 		{
 			auto linedef = sidedef->linedef;
-			if (linedef && linedef->validcount != ::validcount)
+			if (linedef && !marks.LineMarked(linedef))
 			{
+				// The light is not relinked while it stays within the slack distance, so
+				// both tests must hold for any position within that distance, not just
+				// this one. The margin is the slack scaled by the length of the line,
+				// because the side test is not normalized.
+				double dx = v2->fX() - v1->fX(), dy = v2->fY() - v1->fY();
+				double side = (pos.Y - v1->fY()) * dx + (v1->fX() - pos.X) * dy;
+				double margin = set.slack > 0 ? set.slack * g_sqrt(dx * dx + dy * dy) : 0.;
+
 				// light is in front of the seg
-				if ((pos.Y - v1->fY()) * (v2->fX() - v1->fX()) + (v1->fX() - pos.X) * (v2->fY() - v1->fY()) <= 0)
+				if (side <= margin)
 				{
-					linedef->validcount = ::validcount;
-					touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
+					marks.MarkLine(linedef);
+					set.sides.Push(sidedef);
 				}
-				else if (linedef->sidedef[0] == sidedef && linedef->sidedef[1] == nullptr)
+				if (side > -margin && linedef->sidedef[0] == sidedef && linedef->sidedef[1] == nullptr)
 				{
 					hitonesidedback = true;
 				}
@@ -571,13 +686,12 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				if (port && port->mType == PORTT_LINKED)
 				{
 					line_t *other = port->mDestination;
-					if (other->validcount != ::validcount)
+					if (!marks.LineMarked(other))
 					{
 						subsector_t *othersub = Level->PointInRenderSubsector(other->v1->fPos() + other->Delta() / 2);
 						FSection *othersect = othersub->section;
-						if (othersect->validcount != ::validcount)
+						if (marks.MarkSection(Level, othersect))
 						{
-							othersect->validcount = ::validcount;
 							collected_ss.Push({ othersect, PosRelative(other->frontsector->PortalGroup) });
 						}
 					}
@@ -587,9 +701,11 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 
 		for (auto &segment : section->segments)
 		{
+			if (alloutside) break;
+
 			// check distance from x/y to seg and if within radius add this seg and, if present the opposing subsector (lather/rinse/repeat)
 			// If out of range we do not need to bother with this seg.
-			if (DistToSeg(pos, segment.start, segment.end) <= radius)
+			if (allinside || DistToSeg(pos, segment.start, segment.end) <= radius)
 			{
 				auto sidedef = segment.sidedef;
 				if (sidedef)
@@ -601,9 +717,8 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				if (partner)
 				{
 					FSection *sect = partner->section;
-					if (sect != nullptr && sect->validcount != dl_validcount)
+					if (sect != nullptr && marks.MarkSection(Level, sect))
 					{
-						sect->validcount = dl_validcount;
 						collected_ss.Push({ sect, pos });
 					}
 				}
@@ -611,8 +726,10 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 		}
 		for (auto side : section->sides)
 		{
+			if (alloutside) break;
+
 			auto v1 = side->V1(), v2 = side->V2();
-			if (DistToSeg(pos, v1, v2) <= radius)
+			if (allinside || DistToSeg(pos, v1, v2) <= radius)
 			{
 				processSide(side, v1, v2);
 			}
@@ -626,9 +743,8 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::ceiling);
 				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
 				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				if (marks.MarkSection(Level, othersect))
 				{
-					othersect->validcount = dl_validcount;
 					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
 				}
 			}
@@ -641,24 +757,51 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::floor);
 				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
 				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				if (marks.MarkSection(Level, othersect))
 				{
-					othersect->validcount = dl_validcount;
 					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
 				}
 			}
 		}
 	}
-	shadowmapped = hitonesidedback && !DontShadowmap();
+	set.shadowmapped = hitonesidedback && !DontShadowmap();
 }
 
 //==========================================================================
 //
-// Link the light into the world
+// Collects everything the light touches without changing any link.
+// This only reads level data so it is safe to run on a worker thread,
+// as long as every thread uses its own marks.
 //
 //==========================================================================
 
-void FDynamicLight::LinkLight()
+void FDynamicLight::CollectLinks(FLightLinkMarks &marks, FLightLinkSet &set) const
+{
+	set.sections.Clear();
+	set.sides.Clear();
+	set.section = nullptr;
+	set.slack = float(MAX(0, *r_lightrelinkdistance));
+	set.shadowmapped = shadowmapped;
+
+	if (radius>0)
+	{
+		// passing in radius*radius allows us to do a distance check without any calls to sqrt
+		FSection *sect = Level->PointInRenderSubsector(Pos)->section;
+		float linkradius = radius + set.slack;
+
+		marks.Begin(Level);
+		CollectWithinRadius(Pos, sect, linkradius * linkradius, marks, set);
+		set.section = sect;
+	}
+}
+
+//==========================================================================
+//
+// Replaces the light's links with the collected set
+//
+//==========================================================================
+
+void FDynamicLight::ApplyLinks(const FLightLinkSet &set)
 {
 	// mark the old light nodes
 	FLightNode * node;
@@ -676,16 +819,20 @@ void FDynamicLight::LinkLight()
 		node = node->nextTarget;
 	}
 
-	if (radius>0)
+	for (auto section : set.sections)
 	{
-		// passing in radius*radius allows us to do a distance check without any calls to sqrt
-		FSection *sect = Level->PointInRenderSubsector(Pos)->section;
-
-		dl_validcount++;
-		::validcount++;
-		CollectWithinRadius(Pos, sect, float(radius*radius));
-
+		touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
 	}
+	for (auto sidedef : set.sides)
+	{
+		touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
+	}
+	shadowmapped = set.shadowmapped;
+	linkPos = Pos;
+	linkSection = set.section;
+	linkRadius = radius;
+	linkSlack = set.slack;
+	LightRelinks++;
 		
 	// Now delete any nodes that won't be used. These are the ones where
 	// m_thing is still nullptr.
@@ -713,6 +860,107 @@ void FDynamicLight::LinkLight()
 	}
 }
 
+//==========================================================================
+//
+// Link the light into the world
+//
+//==========================================================================
+
+void FDynamicLight::LinkLight()
+{
+	static FLightLinkMarks marks;
+	static FLightLinkSet set;
+
+	CollectLinks(marks, set);
+	ApplyLinks(set);
+}
+
+//==========================================================================
+//
+// Ticks all internal dynamic lights of a level.
+//
+// With r_multithreadedlights the lights are ticked in order first, but
+// any relinking they require is only recorded. The expensive collection
+// of touched sections and sides is then spread over a thread pool and
+// the results are linked back in on the main thread in the original
+// order so that the light lists come out exactly as with the serial code.
+//
+//==========================================================================
+
+CVAR(Bool, r_multithreadedlights, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+static ctpl::thread_pool LightLinkPool;
+static TArray<FLightLinkMarks> LightLinkMarks;
+static TArray<FLightLinkSet> LightLinkSets;
+
+void TickDynamicLights(FLevelLocals *Level)
+{
+	static TArray<FDynamicLight *> pending;
+	const unsigned MIN_THREADED_LINKS = 16;	// below this the synchronization costs more than it saves.
+
+	LightRelinks = LightRelinksSkipped = LightNodesLinked = LightNodesUnlinked = 0;
+
+	if (!r_multithreadedlights)
+	{
+		for (auto light = Level->lights; light;)
+		{
+			auto next = light->next;
+			light->Tick();
+			light = next;
+		}
+		return;
+	}
+
+	pending.Clear();
+	PendingLinks = &pending;
+	for (auto light = Level->lights; light;)
+	{
+		auto next = light->next;
+		light->Tick();
+		light = next;
+	}
+	PendingLinks = nullptr;
+
+	if (pending.Size() < MIN_THREADED_LINKS)
+	{
+		for (auto light : pending) light->LinkLight();
+		return;
+	}
+
+	if (LightLinkPool.size() == 0)
+	{
+		LightLinkPool.resize(clamp<int>(std::thread::hardware_concurrency() - 1, 1, 8));
+		LightLinkMarks.Resize(LightLinkPool.size() + 1);
+	}
+	if (LightLinkSets.Size() < pending.Size()) LightLinkSets.Resize(pending.Size());
+
+	// The main thread takes the last slice itself.
+	const unsigned numslices = LightLinkPool.size() + 1;
+	const unsigned slicesize = (pending.Size() + numslices - 1) / numslices;
+	auto collectSlice = [&](unsigned slice)
+	{
+		unsigned start = slice * slicesize;
+		unsigned end = MIN(start + slicesize, pending.Size());
+		for (unsigned i = start; i < end; i++)
+		{
+			pending[i]->CollectLinks(LightLinkMarks[slice], LightLinkSets[i]);
+		}
+	};
+
+	std::vector<std::future<void>> jobs;
+	for (unsigned slice = 0; slice < numslices - 1; slice++)
+	{
+		jobs.push_back(LightLinkPool.push([&, slice](int) { collectSlice(slice); }));
+	}
+	collectSlice(numslices - 1);
+	for (auto &job : jobs) job.wait();
+
+	for (unsigned i = 0; i < pending.Size(); i++)
+	{
+		pending[i]->ApplyLinks(LightLinkSets[i]);
+	}
+}
+
 
 //==========================================================================
 //
@@ -724,6 +972,21 @@ void FDynamicLight::UnlinkLight ()
 	while (touching_sides) touching_sides = DeleteLightNode(touching_sides);
 	while (touching_sector) touching_sector = DeleteLightNode(touching_sector);
 	shadowmapped = false;
+	linkSection = nullptr;
+}
+
+//==========================================================================
+//
+// Link statistics of the last tic
+//
+//==========================================================================
+
+ADD_STAT(lightlinks)
+{
+	FString out;
+	out.Format("Relinks: %u, skipped: %u, nodes linked: %u, unlinked: %u",
+		LightRelinks, LightRelinksSkipped, LightNodesLinked, LightNodesUnlinked);
+	return out;
 }
 
 //==========================================================================
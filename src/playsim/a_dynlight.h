@@ -9,6 +9,8 @@ struct seg_t;
 
 class FSerializer;
 struct FSectionLine;
+struct FLightLinkSet;
+struct FLightLinkMarks;
 
 enum ELightType
 {
@@ -235,13 +237,18 @@ struct FDynamicLight
 
 	void Tick();
 	void UpdateLocation();
+	bool NeedsRelink() const;
 	void LinkLight();
 	void UnlinkLight();
 	void ReleaseLight();
 
+	// Split version of LinkLight: collecting only reads level data and can be run on a worker thread.
+	void CollectLinks(FLightLinkMarks &marks, FLightLinkSet &set) const;
+	void ApplyLinks(const FLightLinkSet &set);
+
 private:
-	double DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *end);
-	void CollectWithinRadius(const DVector3 &pos, FSection *section, float radius);
+	static double DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *end);
+	void CollectWithinRadius(const DVector3 &pos, FSection *section, float radius, FLightLinkMarks &marks, FLightLinkSet &set) const;
 
 public:
 	FCycler m_cycler;
@@ -264,6 +271,10 @@ public:
 	FLightNode * touching_sides;
 	FLightNode * touching_sector;
 	float radius;			// The maximum size the light can be with its current settings.
+	DVector3 linkPos;		// Where the light was when it was last linked,
+	FSection *linkSection;	// the section it was in,
+	float linkRadius;		// its radius
+	float linkSlack;		// and how far it may move before it needs to be relinked.
 	float m_currentRadius;	// The current light size.
 	int m_tickCount;
 	int m_lastUpdate;
@@ -278,4 +289,4 @@ public:
 
 };
 
-
+void TickDynamicLights(FLevelLocals *Level);
@@ -45,7 +45,7 @@
 
 
 static int ThinkCount;
-static cycle_t ThinkCycles;
+cycle_t ThinkCycles;
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
 extern int BotWTG;
@@ -124,12 +124,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 			}
 		} while (count != 0);
 
-		for (auto light = Level->lights; light;)
-		{
-			auto next = light->next;
-			light->Tick();
-			light = next;
-		}
+		TickDynamicLights(Level);
 	}
 	else
 	{
@@ -712,7 +707,7 @@ DEFINE_ACTION_FUNCTION(DThinker, PostBeginPlay)
 void DThinker::CallPostBeginPlay()
 {
 	ObjectFlags |= OF_Spawned;
-	IFVIRTUAL(DThinker, PostBeginPlay)
+	IFOVERRIDENVIRTUAL(DThinker, PostBeginPlay)
 	{
 		// Without the type cast this picks the 'void *' assignment...
 		VMValue params[1] = { (DObject*)this };
@@ -849,7 +844,7 @@ DEFINE_ACTION_FUNCTION(DThinker, Tick)
 
 void DThinker::CallTick()
 {
-	IFVIRTUAL(DThinker, Tick)
+	IFOVERRIDENVIRTUAL(DThinker, Tick)
 	{
 		// Without the type cast this picks the 'void *' assignment...
 		VMValue params[1] = { (DObject*)this };
@@ -6733,6 +6733,111 @@ inline int getshort (int *&pc)
 	return res;
 }
 
+//==========================================================================
+//
+// Fast path of the interpreter
+//
+// The most common simple instructions are decoded only once per module
+// and then run with direct threaded dispatch where the compiler supports
+// it. Anything else leaves the fast path and goes through the big switch
+// in RunScript. The behavior of each instruction must stay exactly the
+// same as there.
+//
+//==========================================================================
+
+#if !defined(COMPGOTO) && defined(__GNUC__)
+#define COMPGOTO 1
+#endif
+
+#define ACS_FASTOPS(xx) \
+	xx(Slow) xx(Nop) xx(PushNumber) xx(PushByte) \
+	xx(PushScriptVar) xx(AssignScriptVar) xx(AddScriptVar) xx(IncScriptVar) xx(DecScriptVar) \
+	xx(PushMapVar) xx(AssignMapVar) \
+	xx(Add) xx(Subtract) xx(Multiply) \
+	xx(EQ) xx(NE) xx(LT) xx(GT) xx(LE) xx(GE) \
+	xx(AndLogical) xx(OrLogical) xx(NegateLogical) \
+	xx(Dup) xx(Swap) xx(Drop) \
+	xx(Goto) xx(IfGoto) xx(IfNotGoto) xx(CaseGoto)
+
+enum EACSFastOp
+{
+#define xx(op) ACSOP_##op,
+	ACS_FASTOPS(xx)
+#undef xx
+	NUM_ACSOPS
+};
+
+const FBehavior::FDecodedOp *FBehavior::DecodeOp(uint32_t ofs)
+{
+	static const FDecodedOp slow = { 0, 0, ACSOP_Slow, 0 };
+
+	// Leave anything close to the end to the full interpreter so that decoding never reads past the code.
+	if (ofs >= (uint32_t)DataSize || DataSize - ofs < 16) return &slow;
+
+	if (DecodedIndex.Size() == 0)
+	{
+		DecodedIndex.Resize(DataSize);
+		memset(DecodedIndex.Data(), 0, DataSize * sizeof(uint32_t));
+	}
+
+	int *pc = Ofs2PC(ofs);
+	const bool littleenhanced = Format == ACS_LittleEnhanced;
+	auto nextbyte = [&]() { return littleenhanced ? getbyte(pc) : LittleLong(*pc++); };
+
+	int pcd;
+	if (littleenhanced)
+	{
+		pcd = getbyte(pc);
+		if (pcd >= 256-16)
+		{
+			pcd = (256-16) + ((pcd - (256-16)) << 8) + getbyte(pc);
+		}
+	}
+	else
+	{
+		pcd = LittleLong(*pc++);
+	}
+
+	FDecodedOp dec = { 0, 0, ACSOP_Slow, 0 };
+	switch (pcd)
+	{
+	case PCD_NOP:				dec.op = ACSOP_Nop; break;
+	case PCD_PUSHNUMBER:		dec.op = ACSOP_PushNumber; dec.arg = uallong(pc[0]); pc++; break;
+	case PCD_PUSHBYTE:			dec.op = ACSOP_PushByte; dec.arg = getbyte(pc); break;
+	case PCD_PUSHSCRIPTVAR:		dec.op = ACSOP_PushScriptVar; dec.arg = nextbyte(); break;
+	case PCD_ASSIGNSCRIPTVAR:	dec.op = ACSOP_AssignScriptVar; dec.arg = nextbyte(); break;
+	case PCD_ADDSCRIPTVAR:		dec.op = ACSOP_AddScriptVar; dec.arg = nextbyte(); break;
+	case PCD_INCSCRIPTVAR:		dec.op = ACSOP_IncScriptVar; dec.arg = nextbyte(); break;
+	case PCD_DECSCRIPTVAR:		dec.op = ACSOP_DecScriptVar; dec.arg = nextbyte(); break;
+	case PCD_PUSHMAPVAR:		dec.op = ACSOP_PushMapVar; dec.arg = nextbyte(); break;
+	case PCD_ASSIGNMAPVAR:		dec.op = ACSOP_AssignMapVar; dec.arg = nextbyte(); break;
+	case PCD_ADD:				dec.op = ACSOP_Add; break;
+	case PCD_SUBTRACT:			dec.op = ACSOP_Subtract; break;
+	case PCD_MULTIPLY:			dec.op = ACSOP_Multiply; break;
+	case PCD_EQ:				dec.op = ACSOP_EQ; break;
+	case PCD_NE:				dec.op = ACSOP_NE; break;
+	case PCD_LT:				dec.op = ACSOP_LT; break;
+	case PCD_GT:				dec.op = ACSOP_GT; break;
+	case PCD_LE:				dec.op = ACSOP_LE; break;
+	case PCD_GE:				dec.op = ACSOP_GE; break;
+	case PCD_ANDLOGICAL:		dec.op = ACSOP_AndLogical; break;
+	case PCD_ORLOGICAL:			dec.op = ACSOP_OrLogical; break;
+	case PCD_NEGATELOGICAL:		dec.op = ACSOP_NegateLogical; break;
+	case PCD_DUP:				dec.op = ACSOP_Dup; break;
+	case PCD_SWAP:				dec.op = ACSOP_Swap; break;
+	case PCD_DROP:				dec.op = ACSOP_Drop; break;
+	case PCD_GOTO:				dec.op = ACSOP_Goto; dec.arg = LittleLong(*pc); pc++; break;
+	case PCD_IFGOTO:			dec.op = ACSOP_IfGoto; dec.arg = LittleLong(*pc); pc++; break;
+	case PCD_IFNOTGOTO:			dec.op = ACSOP_IfNotGoto; dec.arg = LittleLong(*pc); pc++; break;
+	case PCD_CASEGOTO:			dec.op = ACSOP_CaseGoto; dec.arg = uallong(pc[0]); dec.arg2 = uallong(pc[1]); pc += 2; break;
+	default:					break;
+	}
+	dec.size = uint16_t(PC2Ofs(pc) - ofs);
+
+	DecodedIndex[ofs] = DecodedOps.Push(dec) + 1;
+	return &DecodedOps.Last();
+}
+
 static bool CharArrayParms(int &capacity, int &offset, int &a, FACSStackMemory& Stack, int &sp, bool ranged)
 {
 	if (ranged)
@@ -6765,26 +6870,7 @@ PClass *DLevelScript::GetClassForIndex(int index) const
 int DLevelScript::RunScript()
 {
 	DACSThinker *controller = Level->ACSThinker;
-	ACSLocalVariables locals(Localvars);
-	ACSLocalArrays noarrays;
-	ACSLocalArrays *localarrays = &noarrays;
-	ScriptFunction *activeFunction = NULL;
-	FRemapTable *translation = 0;
 	int resultValue = 1;
-	int transi = -1;
-
-	if (InModuleScriptNumber >= 0)
-	{
-		ScriptPtr *ptr = activeBehavior->GetScriptPtr(InModuleScriptNumber);
-		assert(ptr != NULL);
-		if (ptr != NULL)
-		{
-			localarrays = &ptr->LocalArrays;
-		}
-	}
-
-	// Hexen truncates all special arguments to bytes (only when using an old MAPINFO and old ACS format
-	const int specialargmask = ((Level->flags2 & LEVEL2_HEXENHACK) && activeBehavior->GetFormat() == ACS_Old) ? 255 : ~0;
 
 	switch (state)
 	{
@@ -6839,6 +6925,33 @@ int DLevelScript::RunScript()
 		break;
 	}
 
+	// Most scripts on a map are usually waiting for something. Those have nothing
+	// to execute or clean up, so leave before setting up the interpreter state.
+	if (state != SCRIPT_Running && state != SCRIPT_PleaseRemove)
+	{
+		return resultValue;
+	}
+
+	ACSLocalVariables locals(Localvars);
+	ACSLocalArrays noarrays;
+	ACSLocalArrays *localarrays = &noarrays;
+	ScriptFunction *activeFunction = NULL;
+	FRemapTable *translation = 0;
+	int transi = -1;
+
+	if (InModuleScriptNumber >= 0)
+	{
+		ScriptPtr *ptr = activeBehavior->GetScriptPtr(InModuleScriptNumber);
+		assert(ptr != NULL);
+		if (ptr != NULL)
+		{
+			localarrays = &ptr->LocalArrays;
+		}
+	}
+
+	// Hexen truncates all special arguments to bytes (only when using an old MAPINFO and old ACS format
+	const int specialargmask = ((Level->flags2 & LEVEL2_HEXENHACK) && activeBehavior->GetFormat() == ACS_Old) ? 255 : ~0;
+
 	FACSStack stackobj;
 	FACSStackMemory& Stack = stackobj.buffer;
 	int &sp = stackobj.sp;
@@ -6855,6 +6968,181 @@ int DLevelScript::RunScript()
 
 	while (state == SCRIPT_Running)
 	{
+		// Run simple instructions on the fast path until one needs the full interpreter.
+		// It stops one short of the runaway limit, so that the check below triggers
+		// on exactly the same instruction as if everything had been run here.
+		{
+			const FBehavior::FDecodedOp *fop;
+
+#if COMPGOTO
+#define FASTOP(x)	fop_##x
+#define NEXTFASTOP	do { if (runaway >= 2000000 || (fop = activeBehavior->GetDecodedOp(pc))->op == ACSOP_Slow) goto fastdone; \
+						runaway++; pc = (int *)((uint8_t *)pc + fop->size); goto *fastops[fop->op]; } while (0)
+
+			static const void * const fastops[NUM_ACSOPS] =
+			{
+#define xx(op) &&fop_##op,
+				ACS_FASTOPS(xx)
+#undef xx
+			};
+			NEXTFASTOP;
+#else
+#define FASTOP(x)	case ACSOP_##x
+#define NEXTFASTOP	goto fastnext
+
+		fastnext:
+			if (runaway >= 2000000 || (fop = activeBehavior->GetDecodedOp(pc))->op == ACSOP_Slow) goto fastdone;
+			runaway++;
+			pc = (int *)((uint8_t *)pc + fop->size);
+			switch (fop->op)
+#endif
+			{
+#if !COMPGOTO
+			default:
+#endif
+			FASTOP(Slow):
+				goto fastdone;
+
+			FASTOP(Nop):
+				NEXTFASTOP;
+
+			FASTOP(PushNumber):
+			FASTOP(PushByte):
+				PushToStack (fop->arg);
+				NEXTFASTOP;
+
+			FASTOP(PushScriptVar):
+				PushToStack (locals[fop->arg]);
+				NEXTFASTOP;
+
+			FASTOP(AssignScriptVar):
+				locals[fop->arg] = STACK(1);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(AddScriptVar):
+				locals[fop->arg] += STACK(1);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(IncScriptVar):
+				++locals[fop->arg];
+				NEXTFASTOP;
+
+			FASTOP(DecScriptVar):
+				--locals[fop->arg];
+				NEXTFASTOP;
+
+			FASTOP(PushMapVar):
+				PushToStack (*(activeBehavior->MapVars[fop->arg]));
+				NEXTFASTOP;
+
+			FASTOP(AssignMapVar):
+				*(activeBehavior->MapVars[fop->arg]) = STACK(1);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(Add):
+				STACK(2) = STACK(2) + STACK(1);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(Subtract):
+				STACK(2) = STACK(2) - STACK(1);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(Multiply):
+				STACK(2) = STACK(2) * STACK(1);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(EQ):
+				STACK(2) = (STACK(2) == STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(NE):
+				STACK(2) = (STACK(2) != STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(LT):
+				STACK(2) = (STACK(2) < STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(GT):
+				STACK(2) = (STACK(2) > STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(LE):
+				STACK(2) = (STACK(2) <= STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(GE):
+				STACK(2) = (STACK(2) >= STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(AndLogical):
+				STACK(2) = (STACK(2) && STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(OrLogical):
+				STACK(2) = (STACK(2) || STACK(1));
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(NegateLogical):
+				STACK(1) = !STACK(1);
+				NEXTFASTOP;
+
+			FASTOP(Dup):
+				Stack[sp] = Stack[sp-1];
+				sp++;
+				NEXTFASTOP;
+
+			FASTOP(Swap):
+				std::swap(Stack[sp-2], Stack[sp-1]);
+				NEXTFASTOP;
+
+			FASTOP(Drop):
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(Goto):
+				pc = activeBehavior->Ofs2PC (fop->arg);
+				NEXTFASTOP;
+
+			FASTOP(IfGoto):
+				if (STACK(1))
+					pc = activeBehavior->Ofs2PC (fop->arg);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(IfNotGoto):
+				if (!STACK(1))
+					pc = activeBehavior->Ofs2PC (fop->arg);
+				sp--;
+				NEXTFASTOP;
+
+			FASTOP(CaseGoto):
+				if (STACK(1) == fop->arg)
+				{
+					pc = activeBehavior->Ofs2PC (fop->arg2);
+					sp--;
+				}
+				NEXTFASTOP;
+			}
+#undef FASTOP
+#undef NEXTFASTOP
+		fastdone:;
+		}
+
 		if (++runaway > 2000000)
 		{
 			Printf ("Runaway %s terminated\n", ScriptPresentation(script).GetChars());
@@ -382,6 +382,28 @@ public:
 
 	BoundsCheckingArray<int32_t *, NUM_MAPVARS> MapVars;
 
+	// An instruction decoded for the fast path of DLevelScript::RunScript.
+	// The decoded instructions are looked up by their code offset, so a
+	// script's pc still points into the original code and savegames are
+	// not affected.
+	struct FDecodedOp
+	{
+		int32_t arg;		// variable index, value or jump target offset
+		int32_t arg2;		// jump target offset of PCD_CASEGOTO
+		uint16_t op;		// fast path operation, 0 if the full interpreter is needed
+		uint16_t size;		// size of the instruction in the code
+	};
+
+	const FDecodedOp *GetDecodedOp(int *pc)
+	{
+		uint32_t ofs = PC2Ofs(pc);
+		if (ofs < DecodedIndex.Size() && DecodedIndex[ofs] != 0)
+		{
+			return &DecodedOps[DecodedIndex[ofs] - 1];
+		}
+		return DecodeOp(ofs);
+	}
+
 
 private:
 	struct ArrayInfo;
@@ -410,8 +432,11 @@ private:
 	TArray<FBehavior *> Imports;
 	char ModuleName[9];
 	TArray<int> JumpPoints;
+	TArray<uint32_t> DecodedIndex;		// per code offset: index into DecodedOps + 1, 0 if not decoded yet
+	TArray<FDecodedOp> DecodedOps;
 
 	void LoadScriptsDirectory ();
+	const FDecodedOp *DecodeOp(uint32_t ofs);
 
 	static int SortScripts (const void *a, const void *b);
 	void UnencryptStrings ();
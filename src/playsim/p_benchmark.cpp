@@ -0,0 +1,344 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright 2026 the GZDoom developers
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//		Playsim benchmark. Collects per-tic timings of the play simulation
+//		and a checksum of the game state while a demo is being timed with
+//		-timedemo <demo> -benchmark [logfile]
+//
+//		-benchmark also selects the null video and sound backends, so it
+//		runs without a window, a GPU or an audio device.
+//
+//-----------------------------------------------------------------------------
+
+#include "p_local.h"
+#include "p_tick.h"
+#include "m_argv.h"
+#include "m_random.h"
+#include "stats.h"
+#include "actor.h"
+#include "g_levellocals.h"
+#include "actorinlines.h"
+#include "c_dispatch.h"
+#include "d_player.h"
+#include "types.h"
+#include "vmintern.h"
+#include "g_game.h"
+
+extern cycle_t ThinkCycles;
+extern cycle_t SightCycles;
+extern cycle_t ACSTime;
+extern cycle_t VMCycles[10];
+extern cycle_t GCTime;
+
+bool benchmarking;
+
+enum EBenchPhase
+{
+	BENCH_Total,
+	BENCH_Thinkers,
+	BENCH_Sight,
+	BENCH_ACS,
+	BENCH_VM,
+	BENCH_GC,
+	NUM_BENCHPHASES
+};
+
+static const char *PhaseNames[NUM_BENCHPHASES] = { "Playsim", "Thinkers", "Sight checks", "ACS", "ZScript VM", "GC" };
+
+struct FBenchPhase
+{
+	double total;
+	double peak;
+};
+
+static FBenchPhase Phases[NUM_BENCHPHASES];
+static cycle_t TicCycles;
+static double VMStart, GCStart;
+static int BenchTics;
+static uint32_t BenchChecksum;
+static FILE *BenchLog;
+
+//==========================================================================
+//
+// P_BenchmarkChecksum
+//
+// Sums up the state of the RNGs and of every actor in every level.
+// This is meant to detect any divergence between two runs of the same
+// demo, so it covers far more than the netgame consistency check.
+//
+//==========================================================================
+
+static uint32_t P_BenchmarkChecksum()
+{
+	uint32_t sum = FRandom::StaticSumSeeds();
+
+	auto mix = [&](uint32_t val)
+	{
+		sum = (sum ^ val) * 16777619u;
+	};
+
+	for (auto Level : AllLevels())
+	{
+		auto it = Level->GetThinkerIterator<AActor>();
+		AActor *ac;
+
+		while ((ac = it.Next()))
+		{
+			mix(uint32_t(FLOAT2FIXED(ac->X())));
+			mix(uint32_t(FLOAT2FIXED(ac->Y())));
+			mix(uint32_t(FLOAT2FIXED(ac->Z())));
+			mix(ac->Angles.Yaw.BAMs());
+			mix(uint32_t(ac->health));
+			mix(uint32_t(ac->tics));
+		}
+	}
+	return sum;
+}
+
+//==========================================================================
+//
+// P_BenchmarkStart
+//
+//==========================================================================
+
+void P_BenchmarkStart()
+{
+	benchmarking = true;
+	memset(Phases, 0, sizeof(Phases));
+	BenchTics = 0;
+	BenchChecksum = 0;
+
+	const char *logname = Args->CheckValue("-benchmark");
+	if (logname != nullptr)
+	{
+		BenchLog = fopen(logname, "w");
+		if (BenchLog == nullptr)
+		{
+			Printf("Could not open benchmark log %s\n", logname);
+		}
+		else
+		{
+			fprintf(BenchLog, "tic,checksum,playsim,thinkers,sight,acs,vm,gc\n");
+		}
+	}
+}
+
+//==========================================================================
+//
+// P_BenchmarkBeginTic / P_BenchmarkEndTic
+//
+// Wrapped around P_Ticker. The thinker, sight and ACS timers are reset
+// by the playsim itself each tic, the VM and GC ones accumulate so only
+// their change during this tic is counted.
+//
+//==========================================================================
+
+void P_BenchmarkBeginTic()
+{
+	VMStart = VMCycles[0].TimeMS();
+	GCStart = GCTime.TimeMS();
+	TicCycles.Reset();
+	TicCycles.Clock();
+}
+
+void P_BenchmarkEndTic()
+{
+	TicCycles.Unclock();
+
+	double times[NUM_BENCHPHASES];
+	times[BENCH_Total] = TicCycles.TimeMS();
+	times[BENCH_Thinkers] = ThinkCycles.TimeMS();
+	times[BENCH_Sight] = SightCycles.TimeMS();
+	times[BENCH_ACS] = ACSTime.TimeMS();
+	times[BENCH_VM] = MAX(VMCycles[0].TimeMS() - VMStart, 0.);
+	times[BENCH_GC] = MAX(GCTime.TimeMS() - GCStart, 0.);
+
+	for (int i = 0; i < NUM_BENCHPHASES; i++)
+	{
+		Phases[i].total += times[i];
+		Phases[i].peak = MAX(Phases[i].peak, times[i]);
+	}
+
+	uint32_t checksum = P_BenchmarkChecksum();
+	BenchChecksum = (BenchChecksum ^ checksum) * 16777619u;
+	BenchTics++;
+
+	if (BenchLog != nullptr)
+	{
+		fprintf(BenchLog, "%d,%08x,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", BenchTics, checksum,
+			times[BENCH_Total], times[BENCH_Thinkers], times[BENCH_Sight], times[BENCH_ACS], times[BENCH_VM], times[BENCH_GC]);
+	}
+}
+
+//==========================================================================
+//
+// P_BenchmarkReport
+//
+//==========================================================================
+
+void P_BenchmarkReport()
+{
+	if (!benchmarking) return;
+	benchmarking = false;
+
+	if (BenchLog != nullptr)
+	{
+		fclose(BenchLog);
+		BenchLog = nullptr;
+	}
+	if (BenchTics == 0) return;
+
+	double total = Phases[BENCH_Total].total;
+	Printf("Benchmark: %d tics in %.1f ms, %.1f tics per second, checksum %08x\n",
+		BenchTics, total, total > 0 ? BenchTics * 1000. / total : 0., BenchChecksum);
+	Printf("Phase            Total, ms   Averg, ms   Peak, ms\n");
+	for (int i = 0; i < NUM_BENCHPHASES; i++)
+	{
+		Printf("%-14s  %10.3f  %10.4f  %9.4f\n", PhaseNames[i], Phases[i].total, Phases[i].total / BenchTics, Phases[i].peak);
+	}
+}
+
+//==========================================================================
+//
+// CCMD vmcallbench
+//
+// Times calls from native code into script code, using the player's
+// GetGibHealth virtual which is a small script function without side
+// effects, and how much of that is the VM frame setup alone.
+//
+//==========================================================================
+
+CCMD(vmcallbench)
+{
+	AActor *mo = players[consoleplayer].mo;
+	if (mo == nullptr)
+	{
+		Printf("vmcallbench can only be used in a game\n");
+		return;
+	}
+	int count = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 100000000) : 1000000;
+
+	cycle_t timer;
+	int sum = 0;
+	timer.Reset();
+	timer.Clock();
+	for (int i = 0; i < count; i++)
+	{
+		sum += mo->GetGibHealth();
+	}
+	timer.Unclock();
+	double calltime = timer.TimeMS() * 1e6 / count;
+	Printf("%d calls: %.1f ns per call (%d)\n", count, calltime, sum);
+
+	unsigned index = GetVirtualIndex(RUNTIME_CLASS(AActor), "GetGibHealth");
+	VMFunction *func = mo->GetClass()->Virtuals[index];
+	if (!(func->VarFlags & VARF_Native))
+	{
+		timer.Reset();
+		timer.Clock();
+		for (int i = 0; i < count; i++)
+		{
+			GlobalVMStack.AllocFrame(static_cast<VMScriptFunction *>(func));
+			GlobalVMStack.PopFrame();
+		}
+		timer.Unclock();
+		Printf("Frame setup: %.1f ns per call\n", timer.TimeMS() * 1e6 / count);
+	}
+}
+
+//==========================================================================
+//
+// CCMD pointinsubsectorbench
+//
+// Compares the grid accelerated subsector lookups against walking the
+// full BSP for random points inside the map, for both the game and the
+// render nodes. Any difference in the results is reported.
+//
+//==========================================================================
+
+CCMD(pointinsubsectorbench)
+{
+	if (gamestate != GS_LEVEL || primaryLevel->HeadGamenode() == nullptr)
+	{
+		Printf("pointinsubsectorbench can only be used in a game\n");
+		return;
+	}
+	auto Level = primaryLevel;
+	int count = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 100000000) : 1000000;
+
+	double minx = DBL_MAX, miny = DBL_MAX, maxx = -DBL_MAX, maxy = -DBL_MAX;
+	for (auto &v : Level->vertexes)
+	{
+		minx = MIN(minx, v.fX());
+		maxx = MAX(maxx, v.fX());
+		miny = MIN(miny, v.fY());
+		maxy = MAX(maxy, v.fY());
+	}
+
+	// Use a private generator so that this does not disturb the game's RNGs.
+	TArray<DVector2> points(count, true);
+	uint32_t seed = 1;
+	auto rnd = [&]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / double(1 << 24); };
+	for (auto &p : points)
+	{
+		p.X = minx + rnd() * (maxx - minx);
+		p.Y = miny + rnd() * (maxy - miny);
+	}
+
+	cycle_t gridtime, walktime;
+	int mismatches = 0;
+	int sum = 0;
+
+	gridtime.Reset();
+	gridtime.Clock();
+	for (auto &p : points) sum += Level->PointInSector(p)->Index();
+	gridtime.Unclock();
+
+	walktime.Reset();
+	walktime.Clock();
+	for (auto &p : points) sum -= FNodeGrid::Descend(Level->HeadGamenode(), FloatToFixed(p.X), FloatToFixed(p.Y))->sector->Index();
+	walktime.Unclock();
+
+	for (auto &p : points)
+	{
+		if (Level->PointInSector(p) != FNodeGrid::Descend(Level->HeadGamenode(), FloatToFixed(p.X), FloatToFixed(p.Y))->sector) mismatches++;
+	}
+	Printf("Game nodes: %.2f M lookups/s with grid, %.2f M lookups/s without\n", count / gridtime.TimeMS() / 1000., count / walktime.TimeMS() / 1000.);
+
+	if (Level->nodes.Size() > 0)
+	{
+		gridtime.Reset();
+		gridtime.Clock();
+		for (auto &p : points) sum += Level->PointInRenderSubsector(p)->Index();
+		gridtime.Unclock();
+
+		walktime.Reset();
+		walktime.Clock();
+		for (auto &p : points) sum -= FNodeGrid::Descend(Level->HeadNode(), FloatToFixed(p.X), FloatToFixed(p.Y))->Index();
+		walktime.Unclock();
+
+		for (auto &p : points)
+		{
+			if (Level->PointInRenderSubsector(p) != FNodeGrid::Descend(Level->HeadNode(), FloatToFixed(p.X), FloatToFixed(p.Y))) mismatches++;
+		}
+		Printf("Render nodes: %.2f M lookups/s with grid, %.2f M lookups/s without\n", count / gridtime.TimeMS() / 1000., count / walktime.TimeMS() / 1000.);
+	}
+	Printf("%d mismatches (%d), grid has %u x %u cells\n", mismatches, sum, Level->gamenodegrid.width, Level->gamenodegrid.height);
+}
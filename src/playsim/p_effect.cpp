@@ -49,6 +49,7 @@
 #include "vm.h"
 #include "actorinlines.h"
 #include "g_game.h"
+#include "ctpl.h"
 
 CVAR (Int, cl_rockettrails, 1, CVAR_ARCHIVE);
 CVAR (Bool, r_rail_smartspiral, 0, CVAR_ARCHIVE);
@@ -129,7 +130,7 @@ void P_InitParticles (FLevelLocals *Level)
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	int NumParticles = clamp<int>(num, 100, 65535);
+	int NumParticles = clamp<int>(num, 100, MAX_PARTICLES);
 
 	Level->Particles.Resize(NumParticles);
 	P_ClearParticles (Level);
@@ -157,13 +158,14 @@ void P_FindParticleSubsectors (FLevelLocals *Level)
 		Level->ParticlesInSubsec.Reserve (Level->subsectors.Size() - Level->ParticlesInSubsec.Size());
 	}
 
-	fillshort (&Level->ParticlesInSubsec[0], Level->subsectors.Size(), NO_PARTICLE);
+	// NO_PARTICLE has all bits set.
+	memset (&Level->ParticlesInSubsec[0], 0xff, Level->subsectors.Size() * sizeof(Level->ParticlesInSubsec[0]));
 
 	if (!r_particles)
 	{
 		return;
 	}
-	for (uint16_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
+	for (uint32_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
 	{
 		 // Try to reuse the subsector from the last portal check, if still valid.
 		if (Level->Particles[i].subsector == nullptr) Level->Particles[i].subsector = Level->PointInRenderSubsector(Level->Particles[i].Pos);
@@ -210,65 +212,167 @@ void P_InitEffects ()
 	blood2 = ParticleColor(RPART(kind)/3, GPART(kind)/3, BPART(kind)/3);
 }
 
-void P_ThinkParticles (FLevelLocals *Level)
+//==========================================================================
+//
+// MoveParticle
+//
+// Fades and moves a single particle. Returns false if it has expired.
+// This only writes to the particle itself, so it may be called for
+// different particles on multiple threads at once.
+//
+//==========================================================================
+
+static bool MoveParticle(FLevelLocals *Level, particle_t *particle, bool frozen)
 {
-	int i;
-	particle_t *particle, *prev;
+	if (!particle->notimefreeze && frozen)
+	{
+		return true;
+	}
 
-	i = Level->ActiveParticles;
-	prev = NULL;
-	while (i != NO_PARTICLE)
+	auto oldtrans = particle->alpha;
+	particle->alpha -= particle->fadestep;
+	particle->size += particle->sizestep;
+	if (particle->alpha <= 0 || oldtrans < particle->alpha || --particle->ttl <= 0 || (particle->size <= 0))
+	{ // The particle has expired
+		return false;
+	}
+
+	// A particle that does not move horizontally stays in its subsector.
+	bool samesubsector = particle->subsector != nullptr && particle->Vel.X == 0 && particle->Vel.Y == 0;
+
+	// Handle crossing a line portal
+	DVector2 newxy = Level->GetPortalOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
+	particle->Pos.X = newxy.X;
+	particle->Pos.Y = newxy.Y;
+	particle->Pos.Z += particle->Vel.Z;
+	particle->Vel += particle->Acc;
+	if (!samesubsector) particle->subsector = Level->PointInRenderSubsector(particle->Pos);
+	sector_t *s = particle->subsector->sector;
+	// Handle crossing a sector portal.
+	if (!s->PortalBlocksMovement(sector_t::ceiling))
 	{
-		particle = &Level->Particles[i];
-		i = particle->tnext;
-		if (!particle->notimefreeze && Level->isFrozen())
+		if (particle->Pos.Z > s->GetPortalPlaneZ(sector_t::ceiling))
 		{
-			prev = particle;
-			continue;
+			particle->Pos += s->GetPortalDisplacement(sector_t::ceiling);
+			particle->subsector = NULL;
 		}
-		
-		auto oldtrans = particle->alpha;
-		particle->alpha -= particle->fadestep;
-		particle->size += particle->sizestep;
-		if (particle->alpha <= 0 || oldtrans < particle->alpha || --particle->ttl <= 0 || (particle->size <= 0))
-		{ // The particle has expired, so free it
-			memset (particle, 0, sizeof(particle_t));
-			if (prev)
-				prev->tnext = i;
-			else
-				Level->ActiveParticles = i;
-			particle->tnext = Level->InactiveParticles;
-			Level->InactiveParticles = (int)(particle - Level->Particles.Data());
-			continue;
+	}
+	else if (!s->PortalBlocksMovement(sector_t::floor))
+	{
+		if (particle->Pos.Z < s->GetPortalPlaneZ(sector_t::floor))
+		{
+			particle->Pos += s->GetPortalDisplacement(sector_t::floor);
+			particle->subsector = NULL;
 		}
+	}
+	return true;
+}
 
-		// Handle crossing a line portal
-		DVector2 newxy = Level->GetPortalOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
-		particle->Pos.X = newxy.X;
-		particle->Pos.Y = newxy.Y;
-		particle->Pos.Z += particle->Vel.Z;
-		particle->Vel += particle->Acc;
-		particle->subsector = Level->PointInRenderSubsector(particle->Pos);
-		sector_t *s = particle->subsector->sector;
-		// Handle crossing a sector portal.
-		if (!s->PortalBlocksMovement(sector_t::ceiling))
+//==========================================================================
+//
+// P_ThinkParticles
+//
+// With r_multithreadedparticles and enough active particles, the list is
+// flattened into an array that gets moved on a thread pool. The expired
+// particles are freed afterward in list order, so the active and free
+// lists come out exactly as with the serial code.
+// Maps with line portals are always done serially because the portal
+// traverser's intercept list is shared.
+//
+//==========================================================================
+
+CVAR(Bool, r_multithreadedparticles, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+static ctpl::thread_pool ParticlePool;
+
+void P_ThinkParticles (FLevelLocals *Level)
+{
+	static TArray<uint32_t> order;
+	static TArray<uint8_t> alive;
+	const unsigned MIN_THREADED_PARTICLES = 4096;	// below this the synchronization costs more than it saves.
+	const bool frozen = Level->isFrozen();
+
+	order.Clear();
+	if (r_multithreadedparticles && !Level->PortalBlockmap.containsLines)
+	{
+		for (uint32_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
 		{
-			if (particle->Pos.Z > s->GetPortalPlaneZ(sector_t::ceiling))
-			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::ceiling);
-				particle->subsector = NULL;
-			}
+			order.Push(i);
 		}
-		else if (!s->PortalBlocksMovement(sector_t::floor))
+	}
+	const bool threaded = order.Size() >= MIN_THREADED_PARTICLES;
+	if (!threaded)
+	{
+		uint32_t i;
+		particle_t *particle, *prev;
+
+		i = Level->ActiveParticles;
+		prev = NULL;
+		while (i != NO_PARTICLE)
 		{
-			if (particle->Pos.Z < s->GetPortalPlaneZ(sector_t::floor))
-			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::floor);
-				particle->subsector = NULL;
+			particle = &Level->Particles[i];
+			i = particle->tnext;
+			if (!MoveParticle(Level, particle, frozen))
+			{ // The particle has expired, so free it
+				memset (particle, 0, sizeof(particle_t));
+				if (prev)
+					prev->tnext = i;
+				else
+					Level->ActiveParticles = i;
+				particle->tnext = Level->InactiveParticles;
+				Level->InactiveParticles = (int)(particle - Level->Particles.Data());
+				continue;
 			}
+			prev = particle;
+		}
+		return;
+	}
+
+	if (ParticlePool.size() == 0)
+	{
+		ParticlePool.resize(clamp<int>(std::thread::hardware_concurrency() - 1, 1, 8));
+	}
+	alive.Resize(order.Size());
+
+	// The main thread takes the last slice itself.
+	const unsigned numslices = ParticlePool.size() + 1;
+	const unsigned slicesize = (order.Size() + numslices - 1) / numslices;
+	auto moveSlice = [&](unsigned slice)
+	{
+		unsigned start = slice * slicesize;
+		unsigned end = MIN(start + slicesize, order.Size());
+		for (unsigned k = start; k < end; k++)
+		{
+			alive[k] = MoveParticle(Level, &Level->Particles[order[k]], frozen);
+		}
+	};
+
+	std::vector<std::future<void>> jobs;
+	for (unsigned slice = 0; slice < numslices - 1; slice++)
+	{
+		jobs.push_back(ParticlePool.push([&, slice](int) { moveSlice(slice); }));
+	}
+	moveSlice(numslices - 1);
+	for (auto &job : jobs) job.wait();
+
+	uint32_t *link = &Level->ActiveParticles;
+	for (unsigned k = 0; k < order.Size(); k++)
+	{
+		auto index = order[k];
+		particle_t *particle = &Level->Particles[index];
+		if (alive[k])
+		{
+			*link = index;
+			link = &particle->tnext;
+		}
+		else
+		{ // The particle has expired, so free it
+			memset (particle, 0, sizeof(particle_t));
+			particle->tnext = Level->InactiveParticles;
+			Level->InactiveParticles = index;
 		}
-		prev = particle;
 	}
+	*link = NO_PARTICLE;
 }
 
 enum PSFlag
@@ -5844,8 +5844,31 @@ int P_GetRadiusDamage(AActor *self, AActor *thing, int damage, int distance, int
 // P_RadiusAttack
 // Source is the creature that caused the explosion at spot.
 //
+// The target lists are kept around between calls. Damaging a target can
+// set off another explosion before the current one is done (e.g. chains of
+// barrels), so every nesting level gets its own list.
+//
 //==========================================================================
 
+static TDeletingArray<TArray<AActor*>*> RadiusAttackTargets;
+static unsigned RadiusAttackDepth;
+
+struct FRadiusAttackTargets
+{
+	TArray<AActor*> &targets;
+
+	static TArray<AActor*> &Get()
+	{
+		if (RadiusAttackDepth == RadiusAttackTargets.Size()) RadiusAttackTargets.Push(new TArray<AActor*>);
+		auto &list = *RadiusAttackTargets[RadiusAttackDepth++];
+		list.Clear();
+		return list;
+	}
+
+	FRadiusAttackTargets() : targets(Get()) {}
+	~FRadiusAttackTargets() { RadiusAttackDepth--; }
+};
+
 int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bombdistance, FName bombmod,
 	int flags, int fulldamagedistance)
 {
@@ -5864,7 +5887,8 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 
 	P_GeometryRadiusAttack(bombspot, bombsource, bombdamage, bombdistance, bombmod, fulldamagedistance);
 
-	TArray<AActor*> targets;
+	FRadiusAttackTargets list;
+	TArray<AActor*> &targets = list.targets;
 	int count = 0;
 	while ((it.Next(&cres)))
 	{
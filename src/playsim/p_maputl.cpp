@@ -1007,7 +1007,7 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 			}
 			else
 			{
-				size_t hash = ((size_t)me >> 3) % countof(Buckets);
+				unsigned hash = HashActor(me);
 				for (i = Buckets[hash]; i >= 0; )
 				{
 					entry = GetHashEntry(i);
@@ -1019,7 +1019,7 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 				}
 				if (i < 0)
 				{ // Add me to the hash table and return me.
-					if (NumFixedHash < (int)countof(FixedHash))
+					if (NumFixedHash < NUM_FIXEDHASH)
 					{
 						entry = &FixedHash[NumFixedHash];
 						entry->Next = Buckets[hash];
@@ -1034,7 +1034,7 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 						i = DynHash.Reserve(1);
 						entry = &DynHash[i];
 						entry->Next = Buckets[hash];
-						Buckets[hash] = i + countof(FixedHash);
+						Buckets[hash] = i + NUM_FIXEDHASH;
 					}
 					entry->Actor = me;
 					return me;
@@ -1159,9 +1159,11 @@ void FMultiBlockThingsIterator::Reset()
 //
 // FPathTraverse :: Intercepts
 //
+// Each thread has its own list so that traces do not need to share it.
+//
 //===========================================================================
 
-TArray<intercept_t> FPathTraverse::intercepts(128);
+thread_local TArray<intercept_t> FPathTraverse::intercepts(128);
 
 
 //===========================================================================
@@ -1394,22 +1396,38 @@ void FPathTraverse::AddThingIntercepts (int bx, int by, FBlockThingsIterator &it
 
 intercept_t *FPathTraverse::Next()
 {
-	intercept_t *in = NULL;
-
-	double dist = FLT_MAX;
-	for (unsigned scanpos = intercept_index; scanpos < intercepts.Size (); scanpos++)
+	if (!sorted)
 	{
-		intercept_t *scan = &intercepts[scanpos];
-		if (scan->frac < dist && !scan->done)
+		// Sort the intercepts once instead of searching for the closest one on
+		// each call. This must be a stable sort, so that intercepts at the same
+		// distance are returned in the order they were added, as before.
+		// The blocks are walked along the trace, so the list is mostly sorted
+		// already and an insertion sort is quick.
+		unsigned end = intercepts.Size();
+		for (unsigned i = intercept_index + 1; i < end; i++)
 		{
-			dist = scan->frac;
-			in = scan;
+			intercept_t in = intercepts[i];
+			unsigned j = i;
+			while (j > intercept_index && intercepts[j - 1].frac > in.frac)
+			{
+				intercepts[j] = intercepts[j - 1];
+				j--;
+			}
+			intercepts[j] = in;
 		}
+		intercept_next = intercept_index;
+		sorted = true;
 	}
-	
-	if (dist > 1. || in == NULL) return NULL;	// checked everything in range			
-	in->done = true;
-	return in;
+
+	while (intercept_next < intercepts.Size())
+	{
+		intercept_t *in = &intercepts[intercept_next++];
+		if (in->done) continue;
+		if (in->frac > 1.) break;	// checked everything in range
+		in->done = true;
+		return in;
+	}
+	return NULL;
 }
 
 //===========================================================================
@@ -1460,6 +1478,7 @@ void FPathTraverse::init(double x1, double y1, double x2, double y2, int flags,
 
 	validcount++;
 	intercept_index = intercepts.Size();
+	sorted = false;
 	Startfrac = startfrac;
 
 	if (flags & PT_DELTA)
@@ -1937,6 +1956,96 @@ int P_VanillaPointOnLineSide(double x, double y, const line_t* line)
 	return 1;			// back side
 }
 
+//==========================================================================
+//
+// FNodeGrid :: Build
+//
+// For every cell walk down the tree as long as all four corners of the
+// cell are on the same side of the partition line. R_PointOnSide is a
+// linear function of the position as long as the coordinate differences
+// do not overflow, so every point inside the cell will go the same way.
+// Cells where this cannot be guaranteed just stop at that node.
+//
+//==========================================================================
+
+static int CellOnSide(const node_t *node, int64_t x1, int64_t y1, int64_t x2, int64_t y2)
+{
+	int side = -1;
+	for (int i = 0; i < 4; i++)
+	{
+		int64_t dx = node->x - ((i & 1) ? x2 : x1);
+		int64_t dy = ((i & 2) ? y2 : y1) - node->y;
+		if (dx != int32_t(dx) || dy != int32_t(dy)) return -1;
+
+		int s = DMulScale32(int32_t(dy), node->dx, int32_t(dx), node->dy) > 0;
+		if (side == -1) side = s;
+		else if (side != s) return -1;
+	}
+	return side;
+}
+
+void FNodeGrid::Build(node_t *headnode, const TArray<vertex_t> &vertexes)
+{
+	Clear();
+	if (headnode == nullptr || vertexes.Size() == 0) return;
+
+	int64_t minx = INT64_MAX, miny = INT64_MAX, maxx = INT64_MIN, maxy = INT64_MIN;
+	for (auto &v : vertexes)
+	{
+		int64_t x = FloatToFixed(v.fX());
+		int64_t y = FloatToFixed(v.fY());
+		minx = MIN(minx, x);
+		maxx = MAX(maxx, x);
+		miny = MIN(miny, y);
+		maxy = MAX(maxy, y);
+	}
+
+	while ((((maxx - minx) >> shift) + 1) * (((maxy - miny) >> shift) + 1) > MAXCELLS)
+	{
+		shift++;
+	}
+	orgx = minx;
+	orgy = miny;
+	width = unsigned((maxx - minx) >> shift) + 1;
+	height = unsigned((maxy - miny) >> shift) + 1;
+	cells.Resize(width * height);
+
+	const int64_t cellsize = int64_t(1) << shift;
+	for (unsigned cy = 0; cy < height; cy++)
+	{
+		int64_t y1 = orgy + cy * cellsize;
+		for (unsigned cx = 0; cx < width; cx++)
+		{
+			int64_t x1 = orgx + cx * cellsize;
+			void *node = headnode;
+			while (!((size_t)node & 1))
+			{
+				int side = CellOnSide((node_t *)node, x1, y1, x1 + cellsize - 1, y1 + cellsize - 1);
+				if (side < 0) break;
+				node = ((node_t *)node)->children[side];
+			}
+			cells[cy * width + cx] = node;
+		}
+	}
+}
+
+//==========================================================================
+//
+// FNodeGrid :: Descend
+//
+// Walks the BSP from the given node down to the subsector.
+//
+//==========================================================================
+
+subsector_t *FNodeGrid::Descend(void *node, int x, int y)
+{
+	while (!((size_t)node & 1))
+	{
+		node = ((node_t *)node)->children[R_PointOnSide(x, y, (node_t *)node)];
+	}
+	return (subsector_t *)((uint8_t *)node - 1);
+}
+
 //==========================================================================
 //
 // P_PointInSubsector
@@ -1945,20 +2054,12 @@ int P_VanillaPointOnLineSide(double x, double y, const line_t* line)
 
 subsector_t *FLevelLocals::PointInSubsector(double x, double y)
 {
-	int side;
-
 	auto node = HeadGamenode();
 	if (node == nullptr) return &subsectors[0];
 
 	fixed_t xx = FloatToFixed(x);
 	fixed_t yy = FloatToFixed(y);
-	do
-	{
-		side = R_PointOnSide(xx, yy, node);
-		node = (node_t *)node->children[side];
-	} while (!((size_t)node & 1));
-
-	return (subsector_t *)((uint8_t *)node - 1);
+	return FNodeGrid::Descend(gamenodegrid.GetStart(xx, yy, node), xx, yy);
 }
 
 //==========================================================================
@@ -1998,22 +2099,10 @@ sector_t *FLevelLocals::PointInSectorBuggy(double x, double y)
 
 subsector_t *FLevelLocals::PointInRenderSubsector (fixed_t x, fixed_t y)
 {
-	node_t *node;
-	int side;
-	
 	// single subsector is a special case
 	if (nodes.Size() == 0)
 		return &subsectors[0];
-	
-	node = HeadNode();
-	
-	do
-	{
-		side = R_PointOnSide (x, y, node);
-		node = (node_t *)node->children[side];
-	}
-	while (!((size_t)node & 1));
-	
-	return (subsector_t *)((uint8_t *)node - 1);
+
+	return FNodeGrid::Descend(rendernodegrid.GetStart(x, y, HeadNode()), x, y);
 }
 
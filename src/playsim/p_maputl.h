@@ -288,18 +288,27 @@ class FBlockThingsIterator
 
 	FBlockNode *block;
 
-	int Buckets[32];
+	// Actors spanning several blocks are remembered here so that they are only returned once.
+	// Dense crowds easily have dozens of those, so this is sized to avoid falling back
+	// to the dynamic array (and its allocation) for every single position check.
+	enum
+	{
+		NUM_BUCKETS = 64,
+		NUM_FIXEDHASH = 64
+	};
+	int Buckets[NUM_BUCKETS];
 
 	struct HashEntry
 	{
 		AActor *Actor;
 		int Next;
 	};
-	HashEntry FixedHash[10];
+	HashEntry FixedHash[NUM_FIXEDHASH];
 	int NumFixedHash;
 	TArray<HashEntry> DynHash;
 
-	HashEntry *GetHashEntry(int i) { return i < (int)countof(FixedHash) ? &FixedHash[i] : &DynHash[i - countof(FixedHash)]; }
+	HashEntry *GetHashEntry(int i) { return i < NUM_FIXEDHASH ? &FixedHash[i] : &DynHash[i - NUM_FIXEDHASH]; }
+	static unsigned HashActor(AActor *me) { return unsigned(((size_t)me >> 4) ^ ((size_t)me >> 10)) % NUM_BUCKETS; }
 
 	void StartBlock(int x, int y);
 	void SwitchBlock(int x, int y);
@@ -362,12 +371,14 @@ public:
 class FPathTraverse
 {
 protected:
-	static TArray<intercept_t> intercepts;
+	static thread_local TArray<intercept_t> intercepts;
 
 	FLevelLocals *Level;
 	divline_t trace;
 	double Startfrac;
 	unsigned int intercept_index;
+	unsigned int intercept_next;	// position of the next intercept once they are sorted
+	bool sorted;
 	unsigned int intercept_count;
 	unsigned int count;
 
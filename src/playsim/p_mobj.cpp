@@ -4690,7 +4690,7 @@ DEFINE_ACTION_FUNCTION(AActor, BeginPlay)
 
 void AActor::CallBeginPlay()
 {
-	IFVIRTUAL(AActor, BeginPlay)
+	IFOVERRIDENVIRTUAL(AActor, BeginPlay)
 	{
 		// Without the type cast this picks the 'void *' assignment...
 		VMValue params[1] = { (DObject*)this };
@@ -210,6 +210,47 @@ void P_DelSeclist(portnode_t *node, portnode_t *FLinePortal::*sechead)
 		node = P_DelSecnode(node, sechead);
 }
 
+//=============================================================================
+//
+// P_MarkSeclist / P_DelUnusedSecnodes
+//
+// For updating a list in place: First clear all m_thing fields. As each
+// node is added or verified as needed by P_AddSecnode, m_thing will be set
+// properly. Afterward delete all nodes where m_thing is still nullptr.
+// These represent the sectors the Thing has vacated. Nodes that stay keep
+// their place in the sector's list.
+//
+//=============================================================================
+
+template<class nodetype>
+static void P_MarkSeclist(nodetype *node)
+{
+	for (; node; node = node->m_tnext)
+	{
+		node->m_thing = nullptr;
+	}
+}
+
+template<class nodetype, class linktype>
+static nodetype *P_DelUnusedSecnodes(nodetype *list, nodetype *linktype::*listhead)
+{
+	nodetype *node = list;
+	while (node)
+	{
+		if (node->m_thing == nullptr)
+		{
+			if (node == list)
+				list = node->m_tnext;
+			node = P_DelSecnode(node, listhead);
+		}
+		else
+		{
+			node = node->m_tnext;
+		}
+	}
+	return list;
+}
+
 
 //=============================================================================
 // phares 3/14/98
@@ -222,19 +263,7 @@ void P_DelSeclist(portnode_t *node, portnode_t *FLinePortal::*sechead)
 
 msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead)
 {
-	msecnode_t *node;
-
-	// First, clear out the existing m_thing fields. As each node is
-	// added or verified as needed, m_thing will be set properly. When
-	// finished, delete all nodes where m_thing is still nullptr. These
-	// represent the sectors the Thing has vacated.
-
-	node = sector_list;
-	while (node)
-	{
-		node->m_thing = nullptr;
-		node = node->m_tnext;
-	}
+	P_MarkSeclist(sector_list);
 
 	FBoundingBox box(thing->X(), thing->Y(), radius);
 	FBlockLinesIterator it(thing->Level, box);
@@ -269,24 +298,8 @@ msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector
 
 	sector_list = P_AddSecnode(thing->Sector, thing, sector_list, thing->Sector->*seclisthead);
 
-	// Now delete any nodes that won't be used. These are the ones where
-	// m_thing is still nullptr.
-
-	node = sector_list;
-	while (node)
-	{
-		if (node->m_thing == nullptr)
-		{
-			if (node == sector_list)
-				sector_list = node->m_tnext;
-			node = P_DelSecnode(node, seclisthead);
-		}
-		else
-		{
-			node = node->m_tnext;
-		}
-	}
-	return sector_list;
+	// Now delete any nodes that won't be used.
+	return P_DelUnusedSecnodes(sector_list, seclisthead);
 }
 
 //=============================================================================
@@ -336,47 +349,13 @@ portnode_t *P_DelPortalnode(portnode_t *node)
 }
 
 
-//=============================================================================
-//
-// P_AddPortalnode
-//
-//=============================================================================
-
-portnode_t *P_AddPortalnode(FLinePortal *s, AActor *thing, portnode_t *nextnode)
-{
-	portnode_t *node;
-
-	if (s == nullptr)
-	{
-		I_FatalError("AddSecnode of 0 for %s\n", thing->GetClass()->TypeName.GetChars());
-	}
-
-	node = reinterpret_cast<portnode_t*>(P_GetSecnode());
-
-	// killough 4/4/98, 4/7/98: mark new nodes unvisited.
-	node->visited = 0;
-
-	node->m_sector = s; 			// portal
-	node->m_thing = thing; 			// mobj
-	node->m_tprev = nullptr;			// prev node on Thing thread
-	node->m_tnext = nextnode;		// next node on Thing thread
-	if (nextnode)
-		nextnode->m_tprev = node;	// set back link on Thing
-
-									// Add new node at head of portal thread starting at s->touching_thinglist
-
-	node->m_sprev = nullptr;			// prev node on portal thread
-	node->m_snext = s->lineportal_thinglist; // next node on portal thread
-	if (s->lineportal_thinglist)
-		node->m_snext->m_sprev = node;
-	s->lineportal_thinglist = node;
-	return node;
-}
-
 //==========================================================================
 //
 // Handle the lists used to render actors from other portal areas
 //
+// The lists are updated in place so that moving only has to touch the
+// portals and sectors that were entered or left.
+//
 //==========================================================================
 
 void AActor::UpdateRenderSectorList()
@@ -385,7 +364,7 @@ void AActor::UpdateRenderSectorList()
 	if (Pos() != OldRenderPos && !(flags & MF_NOSECTOR))
 	{
 		// Only check if the map contains line portals
-		ClearRenderLineList();
+		P_MarkSeclist(touching_lineportallist);
 		if (Level->PortalBlockmap.containsLines && Pos().XY() != OldRenderPos.XY())
 		{
 			int bx = Level->blockmap.GetBlockX(X());
@@ -400,14 +379,16 @@ void AActor::UpdateRenderSectorList()
 					if (p.mType == PORTT_VISUAL) continue;
 					if (bb.inRange(p.mOrigin) && bb.BoxOnLineSide(p.mOrigin))
 					{
-						touching_lineportallist = P_AddPortalnode(&p, this, touching_lineportallist);
+						touching_lineportallist = P_AddSecnode(&p, this, touching_lineportallist, p.lineportal_thinglist);
 					}
 				}
 			}
 		}
+		touching_lineportallist = P_DelUnusedSecnodes(touching_lineportallist, &FLinePortal::lineportal_thinglist);
+
 		sector_t *sec = Sector;
 		double lasth = -FLT_MAX;
-		ClearRenderSectorList();
+		P_MarkSeclist(touching_sectorportallist);
 		while (!sec->PortalBlocksMovement(sector_t::ceiling))
 		{
 			double planeh = sec->GetPortalPlaneZ(sector_t::ceiling);
@@ -430,6 +411,7 @@ void AActor::UpdateRenderSectorList()
 			sec = sec->Level->PointInSector(newpos);
 			touching_sectorportallist = P_AddSecnode(sec, this, touching_sectorportallist, sec->sectorportal_thinglist);
 		}
+		touching_sectorportallist = P_DelUnusedSecnodes(touching_sectorportallist, &sector_t::sectorportal_thinglist);
 	}
 }
 
@@ -52,7 +52,7 @@ This uses specialized forms of the maputils routines for optimized performance
 
 // Performance meters
 static int sightcounts[6];
-static cycle_t SightCycles;
+cycle_t SightCycles;
 static cycle_t MaxSightCycles;
 
 enum
@@ -875,6 +875,14 @@ sightcounts[0]++;
 		}
 	}
 
+	// Only now check the generated reject, so that rejected pairs still make the RNG call above.
+	if (!t1->Level->CheckRejectGroups(s1, s2))
+	{
+sightcounts[0]++;
+		res = false;
+		goto done;
+	}
+
 	// killough 4/19/98: make fake floors and ceilings block monster view
 
 	if (!(flags & SF_IGNOREWATERBOUNDARY))
@@ -935,6 +943,108 @@ done:
 	return res;
 }
 
+//==========================================================================
+//
+// FLevelLocals :: BuildRejectGroups
+//
+// Generated reject table: Collects all sectors into groups that are
+// connected through two-sided lines, BSP segs or portals. A sight line
+// can never get from one group into another, so P_CheckSight can skip
+// the traversal for any pair of sectors in different groups. Unlike the
+// REJECT lump this remains usable on maps with portals.
+//
+//==========================================================================
+
+void FLevelLocals::BuildRejectGroups()
+{
+	rejectgroups.Clear();
+
+	// If gameplay uses different nodes than the renderer, the segs cannot tell
+	// which sectors an unclosed sector may leak into, so better play it safe.
+	if (gamenodes.Size() > 0 || sectors.Size() == 0) return;
+
+	const int numsectors = sectors.Size();
+	const int numgroups = Displacements.size;
+	TArray<int> parent(numsectors + numgroups, true);
+	for (unsigned i = 0; i < parent.Size(); i++) parent[i] = i;
+
+	auto find = [&](int i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+	auto unite = [&](int a, int b)
+	{
+		a = find(a);
+		b = find(b);
+		if (a < b) parent[b] = a;
+		else if (b < a) parent[a] = b;
+	};
+
+	for (auto &line : lines)
+	{
+		if (line.frontsector == nullptr) continue;
+		if (line.backsector != nullptr)
+		{
+			unite(line.frontsector->Index(), line.backsector->Index());
+		}
+		FLinePortal *port = line.getPortal();
+		if (port != nullptr && port->mDestination != nullptr && port->mDestination->frontsector != nullptr)
+		{
+			unite(line.frontsector->Index(), port->mDestination->frontsector->Index());
+		}
+	}
+
+	// This also covers minisegs, in case a sector is not properly closed.
+	for (auto &seg : segs)
+	{
+		if (seg.PartnerSeg != nullptr && seg.Subsector != nullptr && seg.PartnerSeg->Subsector != nullptr)
+		{
+			unite(seg.Subsector->sector->Index(), seg.PartnerSeg->Subsector->sector->Index());
+		}
+	}
+
+	// A sight line through a linked plane portal may end up anywhere in the portal group on the other side.
+	TArray<bool> groupused(numgroups, true);
+	memset(groupused.Data(), 0, numgroups * sizeof(bool));
+	for (auto &port : sectorPortals)
+	{
+		if (port.mType == PORTS_LINKEDPORTAL && port.mOrigin != nullptr && port.mDestination != nullptr)
+		{
+			int g1 = port.mOrigin->PortalGroup, g2 = port.mDestination->PortalGroup;
+			if (g1 >= 0 && g1 < numgroups && g2 >= 0 && g2 < numgroups)
+			{
+				groupused[g1] = groupused[g2] = true;
+				unite(numsectors + g1, numsectors + g2);
+			}
+		}
+	}
+	for (auto &sec : sectors)
+	{
+		if (sec.PortalGroup >= 0 && sec.PortalGroup < numgroups && groupused[sec.PortalGroup])
+		{
+			unite(sec.Index(), numsectors + sec.PortalGroup);
+		}
+	}
+
+	rejectgroups.Resize(numsectors);
+	int numrejectgroups = 0;
+	for (int i = 0; i < numsectors; i++)
+	{
+		rejectgroups[i] = find(i);
+		if (rejectgroups[i] == i) numrejectgroups++;
+	}
+	if (numrejectgroups <= 1)
+	{
+		// Everything is connected, so there's nothing to reject.
+		rejectgroups.Clear();
+	}
+}
+
 ADD_STAT (sight)
 {
 	FString out;
@@ -358,6 +358,7 @@ bool FLevelLocals::ChangePortalLine(line_t *line, int destid)
 		port->mFlags = port->mDefFlags;
 	}
 	SetPortalRotation(port);
+	BuildRejectGroups();	// sight may now pass between different areas.
 	return true;
 }
 
@@ -750,6 +750,20 @@ public:
 				output.allSubsectors[numsubsectors++] = &Level->subsectors[ssi];
 				Level->subsectors[ssi].section = &output.allSections[curgroup];
 			}
+
+			dest.center = { (dest.bounds.left + dest.bounds.right) / 2, (dest.bounds.top + dest.bounds.bottom) / 2 };
+			double radiussq = 0;
+			for (auto &fseg : dest.segments)
+			{
+				radiussq = MAX(radiussq, (fseg.start->fPos() - dest.center).LengthSquared());
+				radiussq = MAX(radiussq, (fseg.end->fPos() - dest.center).LengthSquared());
+			}
+			for (auto side : dest.sides)
+			{
+				radiussq = MAX(radiussq, (side->V1()->fPos() - dest.center).LengthSquared());
+				radiussq = MAX(radiussq, (side->V2()->fPos() - dest.center).LengthSquared());
+			}
+			dest.boundradius = sqrt(radiussq);
 			curgroup++;
 		}
 	}
@@ -115,6 +115,8 @@ struct FSection
 	sector_t				*sector;
 	FLightNode				*lighthead;			// Light nodes (blended and additive)
 	BoundingRect			 bounds;
+	DVector2				 center;			// bounding circle of all segments and sides
+	double					 boundradius;
 	int						 vertexindex;		// This is relative to the start of the entire sector's vertex plane data because it needs to be used with different sources.
 	int						 vertexcount;
 	int						 validcount;
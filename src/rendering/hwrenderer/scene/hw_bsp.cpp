@@ -46,6 +46,11 @@
 #endif // ARCH_IA32
 
 CVAR(Bool, gl_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CUSTOM_CVAR(Int, gl_bspworkers, BSPLANE_COUNT, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 1) self = 1;
+	else if (self > BSPLANE_COUNT) self = BSPLANE_COUNT;
+}
 
 thread_local bool isWorkerThread;
 ctpl::thread_pool renderPool(1);
@@ -72,7 +77,6 @@ struct RenderJob
 class RenderJobQueue
 {
 	RenderJob pool[300000];	// Way more than ever needed. The largest ever seen on a single viewpoint is around 40000.
-	std::atomic<int> readindex{};
 	std::atomic<int> writeindex{};
 public:
 	void AddJob(int type, subsector_t *sub, seg_t *seg = nullptr)
@@ -83,7 +87,8 @@ public:
 		writeindex++;	// update index only after the value has been written.
 	}
 
-	RenderJob *GetJob()
+	// Every worker sees every job and keeps its own read position, so no job ever needs to be claimed.
+	RenderJob *GetJob(int &readindex)
 	{
 		if (readindex < writeindex) return &pool[readindex++];
 		return nullptr;
@@ -91,22 +96,30 @@ public:
 	
 	void ReleaseAll()
 	{
-		readindex = 0;
 		writeindex = 0;
 	}
 };
 
 static RenderJobQueue jobQueue;	// One static queue is sufficient here. This code will never be called recursively.
 
-void HWDrawInfo::WorkerThread()
+//==========================================================================
+//
+// Each worker processes the job types in its mask and skips the rest.
+// With more than one worker the draw items go into the worker's own
+// lists which get merged afterward.
+//
+//==========================================================================
+
+void HWDrawInfo::WorkerThread(int lane, unsigned jobmask)
 {
 	sector_t *front, *back;
+	int readindex = 0;
 
-	WTTotal.Clock();
+	if (lane == 0) WTTotal.Clock();
 	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
 	while (true)
 	{
-		auto job = jobQueue.GetJob();
+		auto job = jobQueue.GetJob(readindex);
 		if (job == nullptr)
 		{
 #ifdef ARCH_IA32
@@ -123,13 +136,18 @@ void HWDrawInfo::WorkerThread()
 			_mm_pause();
 			_mm_pause();
 #endif // ARCH_IA32
+			continue;
 		}
+		if (!(jobmask & (1 << job->type))) continue;
+		if (CurrentWorkerDrawLists) CurrentWorkerDrawLists->CurrentJob = readindex - 1;
+
 		// Note that the main thread MUST have prepared the fake sectors that get used below!
 		// This worker thread cannot prepare them itself without costly synchronization.
-		else switch (job->type)
+		switch (job->type)
 		{
 		case RenderJob::TerminateJob:
-			WTTotal.Unclock();
+			if (lane == 0) WTTotal.Unclock();
+			CurrentWorkerDrawLists = nullptr;
 			return;
 
 		case RenderJob::WallJob:
@@ -192,7 +210,38 @@ void HWDrawInfo::WorkerThread()
 	}
 }
 
+//==========================================================================
+//
+// Moves the workers' draw items into the real draw lists. Every job is
+// handled by exactly one worker and each worker's items are in job order,
+// so merging by job index gives the same lists a single worker creates.
+//
+//==========================================================================
 
+void HWDrawInfo::MergeWorkerDrawLists(int numlanes)
+{
+	for (int list = 0; list < GLDL_TYPES; list++)
+	{
+		unsigned pos[BSPLANE_COUNT] = {};
+		while (true)
+		{
+			int best = -1;
+			int bestjob = INT_MAX;
+			for (int i = 0; i < numlanes; i++)
+			{
+				auto &jobs = WorkerDrawLists[i].jobs[list];
+				if (pos[i] < jobs.Size() && jobs[pos[i]] < bestjob)
+				{
+					best = i;
+					bestjob = jobs[pos[i]];
+				}
+			}
+			if (best < 0) break;
+			drawlists[list].AppendItem(WorkerDrawLists[best].lists[list], pos[best]++);
+		}
+	}
+	for (int i = 0; i < numlanes; i++) WorkerDrawLists[i].Reset();
+}
 
 
 
@@ -559,7 +608,7 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 {
 	SetupSprite.Clock();
-	for (int i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
+	for (uint32_t i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
 	{
 		if (mClipPortal)
 		{
@@ -809,17 +858,43 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	multithread = gl_multithread;
 	if (multithread)
 	{
+		// Walls (and the portal subsectors they create), flats and sprites are independent enough to be set up on separate workers.
+		// Sprites have to stay with the walls if there are line portals because walls move the actors behind them temporarily.
+		// Don't use more workers than there are free cores, because they spin while waiting for work.
+		int numlanes = clamp<int>(std::thread::hardware_concurrency() - 1, 1, *gl_bspworkers);
+		int spritelane = Level->linePortals.Size() > 0 ? BSPLANE_WALLS : BSPLANE_SPRITES;
+		unsigned jobmasks[BSPLANE_COUNT] = {};
+		auto addjob = [&](int type, int lane) { jobmasks[lane < numlanes ? lane : 0] |= 1 << type; };
+
+		addjob(RenderJob::WallJob, BSPLANE_WALLS);
+		addjob(RenderJob::PortalJob, BSPLANE_WALLS);
+		addjob(RenderJob::FlatJob, BSPLANE_FLATS);
+		addjob(RenderJob::SpriteJob, spritelane);
+		addjob(RenderJob::ParticleJob, spritelane);
+
+		if (renderPool.size() < numlanes) renderPool.resize(numlanes);
 		jobQueue.ReleaseAll();
-		auto future = renderPool.push([&](int id) {
-			WorkerThread();
-		});
+
+		std::future<void> futures[BSPLANE_COUNT];
+		int numworkers = 0;
+		for (int i = 0; i < numlanes; i++)
+		{
+			if (jobmasks[i] == 0) continue;
+			unsigned mask = jobmasks[i] | (1 << RenderJob::TerminateJob);
+			auto worker = numlanes > 1 ? &WorkerDrawLists[i] : nullptr;
+			futures[numworkers++] = renderPool.push([=](int id) {
+				CurrentWorkerDrawLists = worker;
+				WorkerThread(i, mask);
+			});
+		}
 		RenderBSPNode(node);
 
 		jobQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
 		Bsp.Unclock();
 		MTWait.Clock();
-		future.wait();
+		for (int i = 0; i < numworkers; i++) futures[i].wait();
 		MTWait.Unclock();
+		if (numlanes > 1) MergeWorkerDrawLists(numlanes);
 	}
 	else
 	{
@@ -409,7 +409,7 @@ void HWViewpointUniforms::SetDefaults(HWDrawInfo *drawInfo)
 
 HWDecal *HWDrawInfo::AddDecal(bool onmirror)
 {
-	auto decal = (HWDecal*)RenderDataAllocator.Alloc(sizeof(HWDecal));
+	auto decal = (HWDecal*)GetRenderDataAllocator().Alloc(sizeof(HWDecal));
 	Decals[onmirror ? 1 : 0].Push(decal);
 	return decal;
 }
@@ -94,6 +94,41 @@ enum DrawListType
 	GLDL_TYPES,
 };
 
+enum EBSPLanes
+{
+	BSPLANE_WALLS,		// walls and portal subsectors
+	BSPLANE_FLATS,
+	BSPLANE_SPRITES,	// things and particles
+	BSPLANE_COUNT
+};
+
+//==========================================================================
+//
+// Draw lists of one BSP worker thread. These get merged into the
+// HWDrawInfo's lists in job order once the BSP has been processed.
+//
+//==========================================================================
+
+struct HWWorkerDrawLists
+{
+	HWDrawList lists[GLDL_TYPES];
+	TArray<int> jobs[GLDL_TYPES];	// the render job each draw item was created by.
+	FMemArena Allocator{ 1024 * 1024 };
+	int CurrentJob = 0;
+
+	void Reset()
+	{
+		for (int i = 0; i < GLDL_TYPES; i++)
+		{
+			lists[i].Reset();
+			jobs[i].Clear();
+		}
+	}
+};
+
+extern HWWorkerDrawLists WorkerDrawLists[BSPLANE_COUNT];
+extern thread_local HWWorkerDrawLists *CurrentWorkerDrawLists;
+
 
 struct HWDrawInfo
 {
@@ -190,7 +225,8 @@ private:
 	subsector_t *currentsubsector;	// used by the line processing code.
 	sector_t *currentsector;
 
-	void WorkerThread();
+	void WorkerThread(int lane, unsigned jobmask);
+	void MergeWorkerDrawLists(int numlanes);
 
 	void UnclipSubsector(subsector_t *sub);
 	
@@ -305,6 +341,7 @@ public:
 	void ProcessLowerMinisegs(TArray<seg_t *> &lowersegs);
     void AddSubsectorToPortal(FSectorPortalGroup *portal, subsector_t *sub);
     
+    HWDrawList &GetDrawList(int list);
     void AddWall(HWWall *w);
     void AddMirrorSurface(HWWall *w);
 	void AddFlat(HWFlat *flat, bool fog);
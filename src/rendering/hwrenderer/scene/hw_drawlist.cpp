@@ -40,9 +40,19 @@
 
 FMemArena RenderDataAllocator(1024*1024);	// Use large blocks to reduce allocation time.
 
+HWWorkerDrawLists WorkerDrawLists[BSPLANE_COUNT];
+thread_local HWWorkerDrawLists *CurrentWorkerDrawLists;
+
 void ResetRenderDataAllocator()
 {
 	RenderDataAllocator.FreeAll();
+	for (auto &worker : WorkerDrawLists) worker.Allocator.FreeAll();
+}
+
+// The BSP worker threads each allocate from their own arena so that they do not need to synchronize.
+FMemArena &GetRenderDataAllocator()
+{
+	return CurrentWorkerDrawLists ? CurrentWorkerDrawLists->Allocator : RenderDataAllocator;
 }
 
 //==========================================================================
@@ -751,7 +761,7 @@ void HWDrawList::SortFlats()
 
 HWWall *HWDrawList::NewWall()
 {
-	auto wall = (HWWall*)RenderDataAllocator.Alloc(sizeof(HWWall));
+	auto wall = (HWWall*)GetRenderDataAllocator().Alloc(sizeof(HWWall));
 	drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(wall)));
 	return wall;
 }
@@ -763,7 +773,7 @@ HWWall *HWDrawList::NewWall()
 //==========================================================================
 HWFlat *HWDrawList::NewFlat()
 {
-	auto flat = (HWFlat*)RenderDataAllocator.Alloc(sizeof(HWFlat));
+	auto flat = (HWFlat*)GetRenderDataAllocator().Alloc(sizeof(HWFlat));
 	drawitems.Push(HWDrawItem(DrawType_FLAT,flats.Push(flat)));
 	return flat;
 }
@@ -775,11 +785,36 @@ HWFlat *HWDrawList::NewFlat()
 //==========================================================================
 HWSprite *HWDrawList::NewSprite()
 {	
-	auto sprite = (HWSprite*)RenderDataAllocator.Alloc(sizeof(HWSprite));
+	auto sprite = (HWSprite*)GetRenderDataAllocator().Alloc(sizeof(HWSprite));
 	drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(sprite)));
 	return sprite;
 }
 
+//==========================================================================
+//
+// Appends another list's item. Both lists' items are owned by the
+// render data arenas so only the pointer gets copied.
+//
+//==========================================================================
+void HWDrawList::AppendItem(const HWDrawList &src, unsigned index)
+{
+	auto &item = src.drawitems[index];
+	switch (item.rendertype)
+	{
+	case DrawType_WALL:
+		drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(src.walls[item.index])));
+		break;
+
+	case DrawType_FLAT:
+		drawitems.Push(HWDrawItem(DrawType_FLAT, flats.Push(src.flats[item.index])));
+		break;
+
+	case DrawType_SPRITE:
+		drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(src.sprites[item.index])));
+		break;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -4,6 +4,7 @@
 
 extern FMemArena RenderDataAllocator;
 void ResetRenderDataAllocator();
+FMemArena &GetRenderDataAllocator();
 struct HWDrawInfo;
 class HWWall;
 class HWFlat;
@@ -90,6 +91,7 @@ public:
 	HWWall *NewWall();
 	HWFlat *NewFlat();
 	HWSprite *NewSprite();
+	void AppendItem(const HWDrawList &src, unsigned index);
 	void Reset();
 	void SortWalls();
 	void SortFlats();
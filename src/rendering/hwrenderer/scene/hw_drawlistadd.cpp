@@ -31,7 +31,23 @@ EXTERN_CVAR(Bool, gl_seamless)
 
 //==========================================================================
 //
-// 
+// Returns the list a new draw item goes into. On a BSP worker thread
+// this is the worker's own list, which records the current render job
+// so that the merge can restore the single threaded order.
+//
+//==========================================================================
+
+HWDrawList &HWDrawInfo::GetDrawList(int list)
+{
+	auto worker = CurrentWorkerDrawLists;
+	if (worker == nullptr) return drawlists[list];
+	worker->jobs[list].Push(worker->CurrentJob);
+	return worker->lists[list];
+}
+
+//==========================================================================
+//
+//
 //
 //==========================================================================
 
@@ -39,7 +55,7 @@ void HWDrawInfo::AddWall(HWWall *wall)
 {
 	if (wall->flags & HWWall::HWF_TRANSLUCENT)
 	{
-		auto newwall = drawlists[GLDL_TRANSLUCENT].NewWall();
+		auto newwall = GetDrawList(GLDL_TRANSLUCENT).NewWall();
 		*newwall = *wall;
 	}
 	else
@@ -55,7 +71,7 @@ void HWDrawInfo::AddWall(HWWall *wall)
 		{
 			list = masked ? GLDL_MASKEDWALLS : GLDL_PLAINWALLS;
 		}
-		auto newwall = drawlists[list].NewWall();
+		auto newwall = GetDrawList(list).NewWall();
 		*newwall = *wall;
 	}
 }
@@ -69,7 +85,7 @@ void HWDrawInfo::AddWall(HWWall *wall)
 void HWDrawInfo::AddMirrorSurface(HWWall *w)
 {
 	w->type = RENDERWALL_MIRRORSURFACE;
-	auto newwall = drawlists[GLDL_TRANSLUCENTBORDER].NewWall();
+	auto newwall = GetDrawList(GLDL_TRANSLUCENTBORDER).NewWall();
 	*newwall = *w;
 
 	// Invalidate vertices to allow setting of texture coordinates
@@ -121,7 +137,7 @@ void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 		bool masked = flat->gltexture->isMasked() && ((flat->renderflags&SSRF_RENDER3DPLANES) || flat->stack);
 		list = masked ? GLDL_MASKEDFLATS : GLDL_PLAINFLATS;
 	}
-	auto newflat = drawlists[list].NewFlat();
+	auto newflat = GetDrawList(list).NewFlat();
 	*newflat = *flat;
 }
 
@@ -144,7 +160,7 @@ void HWDrawInfo::AddSprite(HWSprite *sprite, bool translucent)
 		list = GLDL_MODELS;
 	}
 
-	auto newsprt = drawlists[list].NewSprite();
+	auto newsprt = GetDrawList(list).NewSprite();
 	*newsprt = *sprite;
 }
 
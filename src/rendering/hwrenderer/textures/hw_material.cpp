@@ -465,6 +465,10 @@ again:
 		FMaterial *hwtex = tex->Material[expand];
 		if (hwtex == NULL && create)
 		{
+			// The BSP workers may want the same material at the same time.
+			std::lock_guard<std::recursive_mutex> lock(FTexture::SetupMutex);
+			hwtex = tex->Material[expand];
+			if (hwtex != NULL) return hwtex;
 			if (expand)
 			{
 				if (tex->isWarped() || tex->isHardwareCanvas() || tex->shaderindex >= FIRST_USER_SHADER || (tex->shaderindex >= SHADER_Specular && tex->shaderindex <= SHADER_PBRBrightmap))
@@ -36,6 +36,17 @@
 #include "image.h"
 #include "v_video.h"
 #include "v_font.h"
+#include "templates.h"
+#include "i_time.h"
+#include "ctpl.h"
+#include <thread>
+#include <vector>
+
+CVAR(Bool, gl_precache_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+// Number of textures that get prepared before their materials are uploaded.
+// This limits the amount of memory held by buffers waiting for upload.
+enum { PRECACHE_BATCH = 64 };
 
 
 //==========================================================================
@@ -65,6 +76,132 @@ static void PrecacheSprite(FTexture *tex, SpriteHits &hits)
 	if (gltex) gltex->PrecacheList(hits);
 }
 
+//==========================================================================
+//
+// FPrecacheBatch
+//
+// Prepares the texture buffers for a group of materials ahead of the
+// upload. Decoding the image data needs the file system and the image
+// source caches which are not thread safe so it stays on the main thread.
+// Upscaling and postprocessing only touch the buffer and the owning
+// texture, so once a texture is decoded it gets handed to a worker while
+// the main thread decodes the next one. All buffers of one texture are
+// processed by the same job because ProcessData modifies the texture.
+// The results are picked up by CreateTexBuffer when the backend creates
+// the hardware textures.
+//
+//==========================================================================
+
+static ctpl::thread_pool PrecachePool;
+
+struct FPrecacheRequest
+{
+	int Translation;
+	int Flags;
+	int IsTransparent;
+	FTextureBuffer Buffer;
+};
+
+struct FPrecacheJob
+{
+	FTexture *Texture;
+	TArray<FPrecacheRequest> Requests;
+};
+
+class FPrecacheBatch
+{
+	TArray<FPrecacheJob> Jobs;
+	TMap<FTexture *, unsigned> JobIndex;
+
+	void AddRequest(FTexture *tex, int translation, bool expanded);
+
+public:
+	void AddMaterial(FMaterial *mat, int translation);
+	int Prepare();
+};
+
+void FPrecacheBatch::AddRequest(FTexture *tex, int translation, bool expanded)
+{
+	if (tex == nullptr || tex->GetImage() == nullptr || tex->GetUseType() == ETextureType::Null) return;
+	if (tex->isHardwareCanvas() || tex->isSWCanvas()) return;
+	if (tex->SystemTextures.GetHardwareTexture(translation, expanded) != nullptr) return;
+
+	// This must match what the backends pass to CreateTexBuffer.
+	int flags = (expanded ? CTF_Expand : 0) | CTF_ProcessData;
+
+	unsigned *pindex = JobIndex.CheckKey(tex);
+	unsigned index;
+	if (pindex == nullptr)
+	{
+		index = Jobs.Reserve(1);
+		Jobs[index].Texture = tex;
+		JobIndex[tex] = index;
+	}
+	else index = *pindex;
+
+	auto &requests = Jobs[index].Requests;
+	for (auto &req : requests)
+	{
+		if (req.Translation == translation && req.Flags == flags) return;
+	}
+	auto &req = requests[requests.Reserve(1)];
+	req.Translation = translation;
+	req.Flags = flags;
+	req.IsTransparent = -1;
+}
+
+void FPrecacheBatch::AddMaterial(FMaterial *mat, int translation)
+{
+	if (mat == nullptr) return;
+	AddRequest(mat->tex, translation, mat->isExpanded());
+	for (auto layer : mat->GetLayerArray())
+	{
+		AddRequest(layer, 0, mat->isExpanded());
+	}
+}
+
+int FPrecacheBatch::Prepare()
+{
+	if (PrecachePool.size() == 0)
+	{
+		PrecachePool.resize(clamp<int>(std::thread::hardware_concurrency() - 1, 1, 8));
+	}
+
+	std::vector<std::future<void>> jobs;
+	jobs.reserve(Jobs.Size());
+	for (auto &job : Jobs)
+	{
+		for (auto &req : job.Requests)
+		{
+			req.Buffer = job.Texture->CreateRawTexBuffer(req.Translation, req.Flags, req.IsTransparent);
+		}
+		jobs.push_back(PrecachePool.push([&job](int)
+		{
+			for (auto &req : job.Requests)
+			{
+				job.Texture->PostProcessTexBuffer(req.Buffer, req.IsTransparent, req.Flags);
+			}
+		}));
+	}
+	for (auto &job : jobs)
+	{
+		job.wait();
+	}
+
+	int count = 0;
+	for (auto &job : Jobs)
+	{
+		for (auto &req : job.Requests)
+		{
+			FTexture::AddPreparedTexBuffer(job.Texture, req.Translation, req.Flags, std::move(req.Buffer));
+			count++;
+		}
+	}
+	Jobs.Clear();
+	JobIndex.Clear();
+	return count;
+}
+
 //==========================================================================
 //
 // DFrameBuffer :: Precache
@@ -250,20 +387,67 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 			}
 		}
 
-		// cache all used textures
-		for (int i = cnt - 1; i >= 0; i--)
+		// cache all used textures. With gl_precache_multithread the buffers for
+		// a batch of textures get prepared in parallel before their upload.
+		FPrecacheBatch batch;
+		double preparetime = 0, uploadtime = 0;
+		int numprepared = 0;
+		int lastprogress = 0;
+		for (int start = cnt - 1; start >= 0; start -= PRECACHE_BATCH)
 		{
-			FTexture *tex = TexMan.ByIndex(i);
-			if (tex != nullptr)
+			int end = MAX(start - PRECACHE_BATCH, -1);
+			uint64_t time = I_nsTime();
+
+			if (gl_precache_multithread)
 			{
-				PrecacheTexture(tex, texhitlist[i]);
-				if (spritehitlist[i] != nullptr && (*spritehitlist[i]).CountUsed() > 0)
+				for (int i = start; i > end; i--)
 				{
-					PrecacheSprite(tex, *spritehitlist[i]);
+					FTexture *tex = TexMan.ByIndex(i);
+					if (tex != nullptr)
+					{
+						if (texhitlist[i] & (FTextureManager::HIT_Wall | FTextureManager::HIT_Flat | FTextureManager::HIT_Sky))
+						{
+							batch.AddMaterial(FMaterial::ValidateTexture(tex, false), 0);
+						}
+						if (spritehitlist[i] != nullptr && (*spritehitlist[i]).CountUsed() > 0)
+						{
+							FMaterial *mat = FMaterial::ValidateTexture(tex, true);
+							SpriteHits::Iterator hit(*spritehitlist[i]);
+							SpriteHits::Pair *hitpair;
+							while (hit.NextPair(hitpair)) batch.AddMaterial(mat, hitpair->Key);
+						}
+					}
 				}
+				numprepared += batch.Prepare();
 			}
-		}
+			uint64_t time2 = I_nsTime();
 
+			for (int i = start; i > end; i--)
+			{
+				FTexture *tex = TexMan.ByIndex(i);
+				if (tex != nullptr)
+				{
+					PrecacheTexture(tex, texhitlist[i]);
+					if (spritehitlist[i] != nullptr && (*spritehitlist[i]).CountUsed() > 0)
+					{
+						PrecacheSprite(tex, *spritehitlist[i]);
+					}
+				}
+			}
+			// Anything the backend did not ask for is not needed anymore.
+			FTexture::FlushPreparedTexBuffers();
+
+			uint64_t time3 = I_nsTime();
+			preparetime += (time2 - time) / 1e6;
+			uploadtime += (time3 - time2) / 1e6;
+
+			int progress = (cnt - 1 - end) * 4 / MAX(cnt, 1);
+			if (progress > lastprogress && progress < 4)
+			{
+				DPrintf(DMSG_NOTIFY, "Precaching textures: %d%%\n", progress * 25);
+				lastprogress = progress;
+			}
+		}
 
 		FImageSource::EndPrecaching();
 
@@ -277,7 +461,8 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 		delete renderer;
 
 		precache.Unclock();
-		DPrintf(DMSG_NOTIFY, "Textures precached in %.3f ms\n", precache.TimeMS());
+		DPrintf(DMSG_NOTIFY, "Textures precached in %.3f ms (%d buffers prepared in %.3f ms, upload %.3f ms)\n",
+			precache.TimeMS(), numprepared, preparetime, uploadtime);
 	}
 
 	delete[] spritehitlist;
@@ -34,6 +34,8 @@
 #include "swrenderer/r_memory.h"
 #include "swrenderer/r_renderthread.h"
 #include "polyrenderer/drawers/poly_triangle.h"
+#include "i_time.h"
+#include "stats.h"
 #include <chrono>
 
 #ifdef WIN32
@@ -41,6 +43,7 @@ void PeekThreadedErrorPane();
 #endif
 
 CVAR(Int, r_multithreaded, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR(Int, r_drawerbands, 4, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR(Int, r_debug_draw, 0, 0);
 
 /////////////////////////////////////////////////////////////////////////////
@@ -73,7 +76,7 @@ void DrawerThreads::Execute(DrawerCommandQueuePtr commands)
 	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
 	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
 	queue->active_commands.push_back(commands);
-	queue->tasks_left += queue->threads.size();
+	queue->tasks_left += queue->threads.size();	// one task per band
 	end_lock.unlock();
 	start_lock.unlock();
 	queue->start_condition.notify_all();
@@ -128,21 +131,62 @@ void DrawerThreads::WaitForWorkers()
 	queue->active_commands.clear();
 }
 
-void DrawerThreads::WorkerMain(DrawerThread *thread)
+// Picks the next band with commands left to run. Each band runs its queues
+// in order, so a band can only be worked on by one thread at a time.
+// The worker's own bands are preferred and other bands on the same NUMA
+// node are stolen before those of other nodes.
+DrawerThread *DrawerThreads::ClaimBand(DrawerWorker *worker)
 {
+	size_t num_queues = active_commands.size();
+	DrawerThread *stolen = nullptr;
+	DrawerThread *remote = nullptr;
+	for (auto &thread : threads)
+	{
+		if (thread.claimed || thread.current_queue >= num_queues)
+			continue;
+
+		if (thread.numa_node == worker->numa_node)
+		{
+			if (thread.band % worker->num_workers == worker->index)
+			{
+				thread.claimed = true;
+				return &thread;
+			}
+			if (!stolen)
+				stolen = &thread;
+		}
+		else if (!remote)
+		{
+			remote = &thread;
+		}
+	}
+
+	DrawerThread *thread = stolen ? stolen : remote;
+	if (thread)
+	{
+		thread->claimed = true;
+		worker->bands_stolen++;
+	}
+	return thread;
+}
+
+void DrawerThreads::WorkerMain(DrawerWorker *worker)
+{
+	std::unique_lock<std::mutex> start_lock(start_mutex);
 	while (true)
 	{
-		// Wait until we are signalled to run:
-		std::unique_lock<std::mutex> start_lock(start_mutex);
-		start_condition.wait(start_lock, [&]() { return thread->current_queue < active_commands.size() || shutdown_flag; });
+		// Wait until there is a band with work left:
+		DrawerThread *thread = nullptr;
+		start_condition.wait(start_lock, [&]() { return shutdown_flag || (thread = ClaimBand(worker)) != nullptr; });
 		if (shutdown_flag)
 			break;
 
 		// Grab the commands
 		DrawerCommandQueuePtr list = active_commands[thread->current_queue];
-		thread->current_queue++;
-		thread->numa_start_y = thread->numa_node * screen->GetHeight() / thread->num_numa_nodes;
-		thread->numa_end_y = (thread->numa_node + 1) * screen->GetHeight() / thread->num_numa_nodes;
+		int numa_start_y = thread->numa_node * screen->GetHeight() / thread->num_numa_nodes;
+		int numa_height = (thread->numa_node + 1) * screen->GetHeight() / thread->num_numa_nodes - numa_start_y;
+		thread->numa_start_y = numa_start_y + thread->band * numa_height / thread->num_bands;
+		thread->numa_end_y = numa_start_y + (thread->band + 1) * numa_height / thread->num_bands;
 		if (thread->poly)
 		{
 			thread->poly->numa_start_y = thread->numa_start_y;
@@ -151,6 +195,7 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 		start_lock.unlock();
 
 		// Do the work:
+		uint64_t start_time = I_nsTime();
 		if (r_debug_draw)
 		{
 			for (auto& command : list->commands)
@@ -167,6 +212,18 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 				command->Execute(thread);
 			}
 		}
+		uint64_t busy_time = I_nsTime() - start_time;
+
+		// Release the band and wake up another worker if it has more queues to run:
+		start_lock.lock();
+		thread->current_queue++;
+		thread->claimed = false;
+		worker->busy_ns += busy_time;
+		worker->bands_run++;
+		bool moreWork = thread->current_queue < active_commands.size();
+		start_lock.unlock();
+		if (moreWork)
+			start_condition.notify_one();
 
 		// Notify main thread that we finished:
 		std::unique_lock<std::mutex> end_lock(end_mutex);
@@ -175,6 +232,8 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 		end_lock.unlock();
 		if (finishedTasks)
 			end_condition.notify_all();
+
+		start_lock.lock();
 	}
 }
 
@@ -205,43 +264,54 @@ void DrawerThreads::StartThreads()
 	else if (r_multithreaded != 1)
 		num_threads = r_multithreaded;
 
-	if (num_threads != (int)threads.size())
+	// More bands than threads lets the threads that finish early take over
+	// bands from the others.
+	int num_bands = clamp<int>(r_drawerbands, 1, 16);
+
+	if (num_threads != (int)workers.size() || num_bands != bands_per_worker)
 	{
 		StopThreads();
 
-		threads.resize(num_threads);
+		workers.resize(num_threads);
+		threads.resize(num_threads * num_bands);
+		bands_per_worker = num_bands;
+		stats_start = I_nsTime();
+
+		DrawerThreads *queue = this;
+		auto setupNode = [&](int numaNode, int numaNodes, int count, DrawerWorker *nodeWorkers, DrawerThread *nodeBands)
+		{
+			for (int i = 0; i < count * num_bands; i++)
+			{
+				DrawerThread *thread = &nodeBands[i];
+				thread->band = i;
+				thread->num_bands = count * num_bands;
+				thread->numa_node = numaNode;
+				thread->num_numa_nodes = numaNodes;
+			}
+			for (int i = 0; i < count; i++)
+			{
+				DrawerWorker *worker = &nodeWorkers[i];
+				worker->index = i;
+				worker->num_workers = count;
+				worker->numa_node = numaNode;
+				worker->thread = std::thread([=]() { queue->WorkerMain(worker); });
+				I_SetThreadNumaNode(worker->thread, numaNode);
+			}
+		};
 
 		if (num_threads == num_numathreads)
 		{
 			int curThread = 0;
 			for (int numaNode = 0; numaNode < I_GetNumaNodeCount(); numaNode++)
 			{
-				for (int i = 0; i < I_GetNumaNodeThreadCount(numaNode); i++)
-				{
-					DrawerThreads *queue = this;
-					DrawerThread *thread = &threads[curThread++];
-					thread->core = i;
-					thread->num_cores = I_GetNumaNodeThreadCount(numaNode);
-					thread->numa_node = numaNode;
-					thread->num_numa_nodes = I_GetNumaNodeCount();
-					thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-					I_SetThreadNumaNode(thread->thread, numaNode);
-				}
+				int count = I_GetNumaNodeThreadCount(numaNode);
+				setupNode(numaNode, I_GetNumaNodeCount(), count, &workers[curThread], &threads[curThread * num_bands]);
+				curThread += count;
 			}
 		}
 		else
 		{
-			for (int i = 0; i < num_threads; i++)
-			{
-				DrawerThreads *queue = this;
-				DrawerThread *thread = &threads[i];
-				thread->core = i;
-				thread->num_cores = num_threads;
-				thread->numa_node = 0;
-				thread->num_numa_nodes = 1;
-				thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-				I_SetThreadNumaNode(thread->thread, 0);
-			}
+			setupNode(0, 1, num_threads, &workers[0], &threads[0]);
 		}
 	}
 }
@@ -252,13 +322,50 @@ void DrawerThreads::StopThreads()
 	shutdown_flag = true;
 	lock.unlock();
 	start_condition.notify_all();
-	for (auto &thread : threads)
-		thread.thread.join();
+	for (auto &worker : workers)
+		worker.thread.join();
+	workers.clear();
 	threads.clear();
+	bands_per_worker = 0;
 	lock.lock();
 	shutdown_flag = false;
 }
 
+void DrawerThreads::GetStats(FString &out)
+{
+	auto queue = Instance();
+	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
+	uint64_t now = I_nsTime();
+	double elapsed = (now - queue->stats_start) / 1e6;
+	queue->stats_start = now;
+
+	out.AppendFormat("%d threads, %d bands\n", (int)queue->workers.size(), (int)queue->threads.size());
+	for (size_t i = 0; i < queue->workers.size(); i++)
+	{
+		DrawerWorker &worker = queue->workers[i];
+		double busy = worker.busy_ns / 1e6;
+		out.AppendFormat("Thread %d: busy %.1f ms (%.0f%%), idle %.1f ms, %d bands run, %d stolen\n", (int)i,
+			busy, elapsed > 0 ? busy * 100 / elapsed : 0., MAX(elapsed - busy, 0.), worker.bands_run, worker.bands_stolen);
+		worker.busy_ns = 0;
+		worker.bands_run = 0;
+		worker.bands_stolen = 0;
+	}
+}
+
+ADD_STAT(drawerthreads)
+{
+	static FString buff;
+	static int64_t lasttime = 0;
+	int64_t t = I_msTime();
+	if (t - lasttime > 1000)
+	{
+		buff.Truncate(0);
+		DrawerThreads::GetStats(buff);
+		lasttime = t;
+	}
+	return buff;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 DrawerCommandQueue::DrawerCommandQueue(RenderMemory *frameMemory) : FrameMemory(frameMemory)
@@ -32,17 +32,27 @@
 // Use multiple threads when drawing
 EXTERN_CVAR(Int, r_multithreaded)
 
+// Number of screen bands per drawer thread
+EXTERN_CVAR(Int, r_drawerbands)
+
 class PolyTriangleThreadData;
 
 namespace swrenderer { class WallColumnDrawerArgs; }
 
-// Worker data for each thread executing drawer commands
+// Worker data for each band of the screen executing drawer commands.
+// The bands are picked up by whichever worker thread is free.
 class DrawerThread
 {
 public:
-	std::thread thread;
 	size_t current_queue = 0;
 
+	// Set while a worker thread is executing commands for this band
+	bool claimed = false;
+
+	// Band of the NUMA block this is drawing
+	int band = 0;
+	int num_bands = 1;
+
 	// Thread line index of this thread
 	int core = 0;
 
@@ -141,6 +151,23 @@ private:
 	int pixelsize;
 };
 
+// OS thread executing the bands
+class DrawerWorker
+{
+public:
+	std::thread thread;
+
+	// Bands with this index modulo the number of workers on the node are tried first
+	int index = 0;
+	int num_workers = 1;
+	int numa_node = 0;
+
+	// Statistics, protected by the start mutex
+	uint64_t busy_ns = 0;
+	int bands_run = 0;
+	int bands_stolen = 0;
+};
+
 class DrawerCommandQueue;
 typedef std::shared_ptr<DrawerCommandQueue> DrawerCommandQueuePtr;
 
@@ -154,6 +181,9 @@ public:
 	static void WaitForWorkers();
 
 	static void ResetDebugDrawPos();
+
+	// Appends the busy time of each worker since the last call
+	static void GetStats(FString &out);
 	
 private:
 	DrawerThreads();
@@ -161,12 +191,16 @@ private:
 	
 	void StartThreads();
 	void StopThreads();
-	void WorkerMain(DrawerThread *thread);
+	void WorkerMain(DrawerWorker *worker);
+	DrawerThread *ClaimBand(DrawerWorker *worker);
 
 	static DrawerThreads *Instance();
 	
 	std::mutex threads_mutex;
 	std::vector<DrawerThread> threads;
+	std::vector<DrawerWorker> workers;
+	int bands_per_worker = 0;
+	uint64_t stats_start = 0;
 
 	std::mutex start_mutex;
 	std::condition_variable start_condition;
@@ -63,6 +63,9 @@ namespace swrenderer
 		int X2 = MAXWIDTH;
 		bool MainThread = false;
 
+		// Time spent in RenderScene::RenderThreadSlice for the last frame, in ms
+		double SliceTime = 0;
+
 		std::unique_ptr<RenderMemory> FrameMemory;
 		std::unique_ptr<RenderOpaquePass> OpaquePass;
 		std::unique_ptr<RenderTranslucentPass> TranslucentPass;
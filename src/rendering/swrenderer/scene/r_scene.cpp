@@ -57,6 +57,7 @@
 #include "swrenderer/r_memory.h"
 #include "swrenderer/r_renderthread.h"
 #include "swrenderer/things/r_playersprite.h"
+#include "i_time.h"
 #include <chrono>
 
 #ifdef WIN32
@@ -66,7 +67,12 @@ void PeekThreadedErrorPane();
 EXTERN_CVAR(Int, r_clearbuffer)
 EXTERN_CVAR(Int, r_debug_draw)
 
-CVAR(Int, r_scene_multithreaded, 0, 0);
+// Splits the scene into vertical slices, each traversed by its own thread.
+// 0 = off, 1 = one slice per hardware thread, other values set the slice count.
+CVAR(Int, r_scene_multithreaded, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+
+// Size the slices by the cost each thread had in the previous frame.
+CVAR(Bool, r_scene_adaptiveslices, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR(Bool, r_models, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 
 bool r_modelscene = false;
@@ -74,6 +80,13 @@ bool r_modelscene = false;
 namespace swrenderer
 {
 	cycle_t WallCycles, PlaneCycles, MaskedCycles, DrawerWaitCycles;
+
+	// State of the scene thread benchmark started by r_scenebench
+	static int BenchThreads, BenchMaxThreads, BenchFrames, BenchFramesLeft;
+	static double BenchTime, BenchBaseTime;
+
+	// Scene that rendered the last main view, for the sceneslices stat
+	static RenderScene *StatScene;
 	
 	RenderScene::RenderScene()
 	{
@@ -82,6 +95,8 @@ namespace swrenderer
 
 	RenderScene::~RenderScene()
 	{
+		if (StatScene == this)
+			StatScene = nullptr;
 		StopThreads();
 	}
 
@@ -215,20 +230,33 @@ namespace swrenderer
 		else if (r_scene_multithreaded != 1)
 			numThreads = r_scene_multithreaded;
 
+		bool mainview = !MainThread()->Viewport->RenderingToCanvas;
+		if (BenchThreads > 0)
+			numThreads = BenchThreads;
+
 		if (numThreads != (int)Threads.size())
 		{
 			StopThreads();
 			StartThreads(numThreads);
 		}
 
+		if (SliceBounds.size() != (size_t)numThreads + 1 || !r_scene_adaptiveslices)
+		{
+			SliceBounds.resize(numThreads + 1);
+			for (int i = 0; i <= numThreads; i++)
+				SliceBounds[i] = i / (double)numThreads;
+		}
+
+		uint64_t starttime = I_nsTime();
+
 		// Setup threads:
 		std::unique_lock<std::mutex> start_lock(start_mutex);
 		for (int i = 0; i < numThreads; i++)
 		{
 			*Threads[i]->Viewport = *MainThread()->Viewport;
 			*Threads[i]->Light = *MainThread()->Light;
-			Threads[i]->X1 = viewwidth * i / numThreads;
-			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
+			Threads[i]->X1 = xs_RoundToInt(viewwidth * SliceBounds[i]);
+			Threads[i]->X2 = i == numThreads - 1 ? viewwidth : xs_RoundToInt(viewwidth * SliceBounds[i + 1]);
 		}
 		run_id++;
 		start_lock.unlock();
@@ -260,13 +288,82 @@ namespace swrenderer
 			finished_threads = 0;
 		}
 
+		// Camera textures have a different workload so only the main view is used for this.
+		if (mainview)
+		{
+			StatScene = this;
+			if (r_scene_adaptiveslices && numThreads > 1)
+				UpdateSliceBounds();
+
+			if (BenchThreads > 0)
+			{
+				BenchTime += (I_nsTime() - starttime) / 1e6;
+				if (--BenchFramesLeft == 0)
+				{
+					double frametime = BenchTime / BenchFrames;
+					if (BenchThreads == 1)
+						BenchBaseTime = frametime;
+					Printf("%7d  %10.3f  %7.2fx\n", BenchThreads, frametime, frametime > 0 ? BenchBaseTime / frametime : 0.);
+
+					BenchThreads = BenchThreads < BenchMaxThreads ? MIN(BenchThreads * 2, BenchMaxThreads) : 0;
+					BenchFramesLeft = BenchFrames;
+					BenchTime = 0;
+				}
+			}
+		}
+
 		// Change main thread back to covering the whole screen for player sprites
 		MainThread()->X1 = 0;
 		MainThread()->X2 = viewwidth;
 	}
 
+	// Moves the slice edges so that each thread gets the same share of the
+	// previous frame's cost. The cost within a slice is assumed to be evenly
+	// spread over its columns, and the edges only move halfway towards the
+	// new position each frame so that a single slow frame doesn't make them
+	// jump around.
+	void RenderScene::UpdateSliceBounds()
+	{
+		size_t numThreads = Threads.size();
+		double total = 0;
+		for (size_t i = 0; i < numThreads; i++)
+			total += Threads[i]->SliceTime;
+		if (total <= 0)
+			return;
+
+		std::vector<double> bounds(numThreads + 1);
+		bounds[0] = 0;
+		bounds[numThreads] = 1;
+		size_t slice = 0;
+		double acc = 0;
+		for (size_t i = 1; i < numThreads; i++)
+		{
+			double target = total * i / numThreads;
+			while (slice < numThreads - 1 && acc + Threads[slice]->SliceTime < target)
+			{
+				acc += Threads[slice]->SliceTime;
+				slice++;
+			}
+			double cost = Threads[slice]->SliceTime;
+			double t = cost > 0 ? clamp((target - acc) / cost, 0., 1.) : 0.5;
+			double edge = SliceBounds[slice] + t * (SliceBounds[slice + 1] - SliceBounds[slice]);
+			bounds[i] = (SliceBounds[i] + edge) * 0.5;
+		}
+
+		// Don't let any slice get too small to catch up again.
+		double minwidth = 0.25 / numThreads;
+		for (size_t i = 1; i < numThreads; i++)
+			bounds[i] = MAX(bounds[i], bounds[i - 1] + minwidth);
+		for (size_t i = numThreads - 1; i > 0; i--)
+			bounds[i] = MIN(bounds[i], bounds[i + 1] - minwidth);
+
+		SliceBounds = bounds;
+	}
+
 	void RenderScene::RenderThreadSlice(RenderThread *thread)
 	{
+		uint64_t starttime = I_nsTime();
+
 		thread->DrawQueue->Clear();
 		thread->FrameMemory->Clear();
 		thread->Clip3D->Cleanup();
@@ -306,6 +403,8 @@ namespace swrenderer
 			thread->TranslucentPass->Render();
 		}
 
+		thread->SliceTime = (I_nsTime() - starttime) / 1e6;
+
 		DrawerThreads::Execute(thread->DrawQueue);
 	}
 
@@ -423,6 +522,40 @@ namespace swrenderer
 		return out;
 	}
 
+	void RenderScene::GetSliceStats(FString &out) const
+	{
+		if (SliceBounds.size() != Threads.size() + 1)
+			return;
+
+		for (size_t i = 0; i < Threads.size(); i++)
+		{
+			int x1 = xs_RoundToInt(viewwidth * SliceBounds[i]);
+			int x2 = xs_RoundToInt(viewwidth * SliceBounds[i + 1]);
+			out.AppendFormat("slice %d: columns %d-%d  %04.2f ms\n", (int)i, x1, x2 - 1, Threads[i]->SliceTime);
+		}
+	}
+
+	ADD_STAT(sceneslices)
+	{
+		FString out;
+		if (StatScene)
+			StatScene->GetSliceStats(out);
+		return out;
+	}
+
+	// Renders the next frames with 1, 2, 4, ... scene threads and prints how
+	// long the scene traversal took on average for each thread count.
+	CCMD(r_scenebench)
+	{
+		BenchFrames = argv.argc() > 1 ? MAX(atoi(argv[1]), 1) : 100;
+		BenchMaxThreads = MAX<int>(std::thread::hardware_concurrency(), 1);
+		BenchThreads = 1;
+		BenchFramesLeft = BenchFrames;
+		BenchTime = 0;
+		Printf("Measuring %d frames for each thread count up to %d\n", BenchFrames, BenchMaxThreads);
+		Printf("Threads  Scene (ms)  Speedup\n");
+	}
+
 	static double f_acc, w_acc, p_acc, m_acc, drawer_acc;
 	static int acc_c;
 
@@ -57,10 +57,14 @@ namespace swrenderer
 
 		RenderThread *MainThread() { return Threads.front().get(); }
 
+		// Column range and traversal time of each slice in the last frame
+		void GetSliceStats(FString &out) const;
+
 	private:
 		void RenderActorView(AActor *actor,bool renderplayersprite, bool dontmaplines);
 		void RenderThreadSlices();
 		void RenderThreadSlice(RenderThread *thread);
+		void UpdateSliceBounds();
 		void RenderPSprites();
 
 		void StartThreads(size_t numThreads);
@@ -71,6 +75,7 @@ namespace swrenderer
 
 		std::unique_ptr<PolyDepthStencil> DepthStencil;
 		std::vector<std::unique_ptr<RenderThread>> Threads;
+		std::vector<double> SliceBounds; // slice edges as a fraction of the view width
 		std::mutex start_mutex;
 		std::condition_variable start_condition;
 		bool shutdown_flag = false;
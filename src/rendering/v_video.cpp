@@ -384,6 +384,38 @@ void V_InitScreenSize ()
 	vid_defheight = height;
 }
 
+//==========================================================================
+//
+// DNullFrameBuffer
+//
+// Used by -benchmark, which only runs the playsim. It neither opens a
+// window nor needs a GPU, so the benchmark can run on a headless machine.
+//
+//==========================================================================
+
+class DNullFrameBuffer : public DFrameBuffer
+{
+public:
+	DNullFrameBuffer (int width, int height)
+		: DFrameBuffer (width, height)
+	{
+	}
+	void InitializeState() override {}
+	void Update() override {}
+	bool IsFullscreen() override { return false; }
+	int GetClientWidth() override { return GetWidth(); }
+	int GetClientHeight() override { return GetHeight(); }
+};
+
+class FNullVideo : public IVideo
+{
+public:
+	DFrameBuffer *CreateFrameBuffer() override
+	{
+		return new DNullFrameBuffer (vid_defwidth, vid_defheight);
+	}
+};
+
 void V_InitScreen()
 {
 	screen = new DDummyFrameBuffer (vid_defwidth, vid_defheight);
@@ -405,7 +437,16 @@ void V_Init2()
 	ticker.SetGenericRepDefault(val, CVAR_Bool);
 
 
-	I_InitGraphics();
+	if (Args->CheckParm("-benchmark"))
+	{
+		// Nothing gets drawn at all, not even the menus or the console.
+		Video = new FNullVideo;
+		nodrawers = noblit = true;
+	}
+	else
+	{
+		I_InitGraphics();
+	}
 
 	Video->SetResolution();	// this only fails via exceptions.
 	Printf ("Resolution: %d x %d\n", SCREENWIDTH, SCREENHEIGHT);
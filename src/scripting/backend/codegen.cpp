@@ -2890,6 +2890,19 @@ error:
 	return nullptr;
 }
 
+//==========================================================================
+//
+// The texture count can change after the code has been compiled, so the
+// bounds check for texture indices reads it from the texture manager.
+//
+//==========================================================================
+
+void *GetTextureCountAddress()
+{
+	auto * ptr = (FArray*)&TexMan.Textures;
+	return &ptr->Count;
+}
+
 //==========================================================================
 //
 //
@@ -2980,11 +2993,9 @@ ExpEmit FxAddSub::Emit(VMFunctionBuilder *build)
 
 texcheck:
 	// Do a bounds check for the texture index. Note that count can change at run time so this needs to read the value from the texture manager.
-	auto * ptr = (FArray*)&TexMan.Textures;
-	auto * countptr = &ptr->Count;
 	ExpEmit bndp(build, REGT_POINTER);
 	ExpEmit bndc(build, REGT_INT);
-	build->Emit(OP_LKP, bndp.RegNum, build->GetConstantAddress(countptr));
+	build->Emit(OP_LKP, bndp.RegNum, build->GetConstantAddress(GetTextureCountAddress()));
 	build->Emit(OP_LW, bndc.RegNum, bndp.RegNum, build->GetConstantInt(0));
 	build->Emit(OP_BOUND_R, to.RegNum, bndc.RegNum);
 	bndp.Free(build);
@@ -6827,6 +6838,43 @@ FxExpression *FxCVar::Resolve(FCompileContext &ctx)
 	return this;
 }
 
+//==========================================================================
+//
+// Returns the address of the variable that holds the CVar's value.
+// For flag and mask CVars this is the value of the underlying int CVar.
+//
+//==========================================================================
+
+void *FxCVar::GetValueAddress(FBaseCVar *cvar)
+{
+	switch (cvar->GetRealType())
+	{
+	case CVAR_Int:
+		return &static_cast<FIntCVar *>(cvar)->Value;
+
+	case CVAR_Color:
+		return &static_cast<FColorCVar *>(cvar)->Value;
+
+	case CVAR_Float:
+		return &static_cast<FFloatCVar *>(cvar)->Value;
+
+	case CVAR_Bool:
+		return &static_cast<FBoolCVar *>(cvar)->Value;
+
+	case CVAR_String:
+		return &static_cast<FStringCVar *>(cvar)->mValue;
+
+	case CVAR_DummyBool:
+		return &static_cast<FFlagCVar *>(cvar)->ValueVar.Value;
+
+	case CVAR_DummyInt:
+		return &static_cast<FMaskCVar *>(cvar)->ValueVar.Value;
+
+	default:
+		return nullptr;
+	}
+}
+
 ExpEmit FxCVar::Emit(VMFunctionBuilder *build)
 {
 	ExpEmit dest(build, CVar->GetRealType() == CVAR_String ? REGT_STRING : ValueType->GetRegType());
@@ -6835,37 +6883,30 @@ ExpEmit FxCVar::Emit(VMFunctionBuilder *build)
 	switch (CVar->GetRealType())
 	{
 	case CVAR_Int:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FIntCVar *>(CVar)->Value));
-		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
-		break;
-
 	case CVAR_Color:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FColorCVar *>(CVar)->Value));
+		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(GetValueAddress(CVar)));
 		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_Float:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FFloatCVar *>(CVar)->Value));
+		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(GetValueAddress(CVar)));
 		build->Emit(OP_LSP, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_Bool:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FBoolCVar *>(CVar)->Value));
+		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(GetValueAddress(CVar)));
 		build->Emit(OP_LBU, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_String:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FStringCVar *>(CVar)->mValue));
+		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(GetValueAddress(CVar)));
 		build->Emit(OP_LS, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_DummyBool:
 	{
-		int *pVal;
 		auto cv = static_cast<FFlagCVar *>(CVar);
-		auto vcv = &cv->ValueVar;
-		pVal = &vcv->Value;
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(pVal));
+		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(GetValueAddress(CVar)));
 		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
 		build->Emit(OP_SRL_RI, dest.RegNum, dest.RegNum, cv->BitNum);
 		build->Emit(OP_AND_RK, dest.RegNum, dest.RegNum, build->GetConstantInt(1));
@@ -6875,7 +6916,7 @@ ExpEmit FxCVar::Emit(VMFunctionBuilder *build)
 	case CVAR_DummyInt:
 	{
 		auto cv = static_cast<FMaskCVar *>(CVar);
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&cv->ValueVar.Value));
+		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(GetValueAddress(CVar)));
 		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
 		build->Emit(OP_AND_RK, dest.RegNum, dest.RegNum, build->GetConstantInt(cv->BitVal));
 		build->Emit(OP_SRL_RI, dest.RegNum, dest.RegNum, cv->BitNum);
@@ -61,6 +61,7 @@ class VMFunctionBuilder;
 class FxJumpStatement;
 
 extern FMemArena FxAlloc;
+void *GetTextureCountAddress();
 
 //==========================================================================
 //
@@ -1383,6 +1384,7 @@ public:
 	FxCVar(FBaseCVar*, const FScriptPosition&);
 	FxExpression *Resolve(FCompileContext&);
 	ExpEmit Emit(VMFunctionBuilder *build);
+	static void *GetValueAddress(FBaseCVar *cvar);
 };
 
 
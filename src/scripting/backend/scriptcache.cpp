@@ -0,0 +1,990 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright 2026 the GZDoom developers
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//		Script code cache. Stores the bytecode of all compiled script
+//		functions so that the next start with the same data can skip
+//		resolving and emitting the function bodies.
+//
+//		All pointers in the code's constant tables are stored as references
+//		by name and looked up again when loading. A function that refers
+//		to something that cannot be found this way is compiled as usual.
+//
+//-----------------------------------------------------------------------------
+
+#include "scriptcache.h"
+#include "codegen.h"
+#include "info.h"
+#include "filesystem.h"
+#include "engineerrors.h"
+#include "cmdlib.h"
+#include "md5.h"
+#include "m_misc.h"
+#include "m_argv.h"
+#include "m_random.h"
+#include "version.h"
+#include "c_cvars.h"
+#include "autosegs.h"
+#include <memory>
+
+CVAR(Bool, vm_scriptcache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+static const char ScriptCacheMagic[4] = { 'Z', 'S', 'C', '1' };
+
+enum ECacheRef
+{
+	REF_Value,			// null or a small integer like a field offset
+	REF_Class,
+	REF_Type,
+	REF_Function,
+	REF_State,
+	REF_Global,			// a static or native global variable
+	REF_CVar,
+	REF_Random,
+	REF_Data,			// a block created by VMFunctionBuilder::GetConstantData
+	REF_TextureCount,
+	REF_Invalid = 255	// more than one object with this name, cannot be cached
+};
+
+struct FCacheRef
+{
+	uint8_t Type;
+	FString Name;
+	uint32_t Index;
+};
+
+// Everything that can be looked up by name, both for writing and reading the cache.
+struct FCacheNames
+{
+	TMap<FString, VMFunction *> Functions;
+	TMap<FString, PType *> Types;
+	TMap<FString, void *> Globals;
+	TMap<uint32_t, FRandom *> RNGs;
+};
+
+struct FStoredFunction
+{
+	VMScriptFunction *Function = nullptr;
+	bool Anonymous = false;
+	TArray<std::pair<void *, unsigned>> Data;
+};
+
+struct FCachedFunction
+{
+	FString Name;
+	unsigned Offset = 0;
+	unsigned Size = 0;
+};
+
+static TArray<int> ScriptCacheLumps;
+static bool CacheActive;		// the cache is used for this compile
+static bool CacheLoaded;		// the file matched and its names and state labels have been added
+static bool CacheKeyMatched;	// the file is valid for a fresh start but cannot be used after a restart, so it must be kept
+static uint8_t CacheKey[16];
+static uint8_t NamesKey[16];
+static int StartNames;
+static unsigned StartLabels;
+static unsigned NumLoaded;
+static TArray<uint8_t> CacheData;
+static TArray<FCachedFunction> CachedFunctions;
+static TArray<FStoredFunction> StoredFunctions;
+static std::unique_ptr<FCacheNames> LoadNames;
+
+//==========================================================================
+//
+// Reading and writing the cache data
+//
+//==========================================================================
+
+struct FCacheWriter
+{
+	TArray<uint8_t> Data;
+
+	void Write(const void *data, size_t len)
+	{
+		if (len == 0) return;
+		unsigned pos = Data.Reserve(len);
+		memcpy(&Data[pos], data, len);
+	}
+	void WriteUInt8(uint8_t v) { Write(&v, 1); }
+	void WriteUInt32(uint32_t v) { Write(&v, 4); }
+	void WriteString(const FString &str)
+	{
+		WriteUInt32(str.Len());
+		Write(str.GetChars(), str.Len());
+	}
+};
+
+struct FCacheReader
+{
+	const uint8_t *Pos, *End;
+
+	FCacheReader(const uint8_t *data, size_t len) : Pos(data), End(data + len) {}
+
+	const uint8_t *Skip(size_t len)
+	{
+		if (size_t(End - Pos) < len) I_Error("Script cache is truncated");
+		auto p = Pos;
+		Pos += len;
+		return p;
+	}
+	void Read(void *data, size_t len)
+	{
+		auto p = Skip(len);
+		if (len > 0) memcpy(data, p, len);
+	}
+	uint8_t ReadUInt8() { uint8_t v; Read(&v, 1); return v; }
+	uint32_t ReadUInt32() { uint32_t v; Read(&v, 4); return v; }
+	FString ReadString()
+	{
+		uint32_t len = ReadUInt32();
+		return FString((const char *)Skip(len), len);
+	}
+	// Guards against corrupt counts causing huge allocations.
+	uint32_t ReadCount(size_t elementsize)
+	{
+		uint32_t count = ReadUInt32();
+		if (size_t(End - Pos) < count * elementsize) I_Error("Script cache is truncated");
+		return count;
+	}
+};
+
+//==========================================================================
+//
+// ScriptCacheAddLump
+//
+//==========================================================================
+
+void ScriptCacheAddLump(int lump)
+{
+	if (lump >= 0 && ScriptCacheLumps.Find(lump) == ScriptCacheLumps.Size())
+	{
+		ScriptCacheLumps.Push(lump);
+	}
+}
+
+//==========================================================================
+//
+// CalcCacheKey
+//
+// The cache is only valid for the exact same engine build and the same
+// set of loaded files. Script sources are checked by content, as are all
+// lumps whose definitions get compiled in as constants: sounds, CVARs
+// and color names.
+//
+// The version string and git hash do not change with local modifications,
+// so the native classes, fields and functions the code binds to are
+// part of the key as well.
+//
+//==========================================================================
+
+static const char *const ScriptCacheDefLumps[] = { "SNDINFO", "S_SKIN", "CVARINFO", "X11R6RGB" };
+
+static void HashLump(MD5Context &md5, int lump)
+{
+	auto data = fileSystem.ReadFile(lump);
+	md5.Update((const uint8_t *)data.GetMem(), (unsigned)data.GetSize());
+}
+
+static void HashNatives(MD5Context &md5)
+{
+	auto hashstring = [&](const char *str)
+	{
+		if (str == nullptr) str = "";
+		md5.Update((const uint8_t *)str, (unsigned)strlen(str) + 1);
+	};
+	auto hashint = [&](uint32_t val)
+	{
+		md5.Update((const uint8_t *)&val, sizeof(val));
+	};
+
+	FAutoSegIterator classes(CRegHead, CRegTail);
+	while (*++classes != nullptr)
+	{
+		auto creg = (ClassReg *)*classes;
+		hashstring(creg->Name);
+		hashint(creg->SizeOf);
+	}
+	FAutoSegIterator fields(FRegHead, FRegTail);
+	while (*++fields != nullptr)
+	{
+		auto field = (FieldDesc *)*fields;
+		hashstring(field->ClassName);
+		hashstring(field->FieldName);
+		hashint((uint32_t)field->FieldOffset);
+		hashint(field->FieldSize);
+		hashint(field->BitValue);
+	}
+	FAutoSegIterator funcs(ARegHead, ARegTail);
+	while (*++funcs != nullptr)
+	{
+		auto afunc = (AFuncDesc *)*funcs;
+		hashstring(afunc->ClassName);
+		hashstring(afunc->FuncName);
+		hashint(afunc->DirectNative.Ptr != nullptr);
+	}
+
+	// This also covers the actor flags, which are added as native fields without going through the field table.
+	// The type table is not used here because its order depends on pointer values.
+	for (auto cls : PClass::AllClasses)
+	{
+		if (cls->VMType == nullptr) continue;
+		auto it = cls->VMType->Symbols.GetIterator();
+		PSymbolTable::MapType::Pair *pair;
+		while (it.NextPair(pair))
+		{
+			auto field = dyn_cast<PField>(pair->Value);
+			if (field != nullptr && (field->Flags & VARF_Native))
+			{
+				hashstring(cls->TypeName.GetChars());
+				hashstring(field->SymbolName.GetChars());
+				hashint((uint32_t)field->Offset);
+				hashint(field->BitValue);
+				hashint(field->Type->Size);
+			}
+		}
+	}
+}
+
+static void CalcCacheKey(uint8_t *digest)
+{
+	MD5Context md5;
+	auto hashstring = [&](const char *str)
+	{
+		md5.Update((const uint8_t *)str, (unsigned)strlen(str) + 1);
+	};
+	auto hashint = [&](uint32_t val)
+	{
+		md5.Update((const uint8_t *)&val, sizeof(val));
+	};
+
+	hashstring(GetVersionString());
+	hashstring(GetGitHash());
+	hashint(sizeof(void *));
+	hashint(0x01020304);	// byte order
+	HashNatives(md5);
+
+	int numlumps = fileSystem.GetNumEntries();
+	hashint(numlumps);
+	for (int i = 0; i < numlumps; i++)
+	{
+		hashstring(fileSystem.GetFileFullName(i, false));
+		hashint(fileSystem.FileLength(i));
+	}
+	for (auto lump : ScriptCacheLumps)
+	{
+		HashLump(md5, lump);
+	}
+	for (auto name : ScriptCacheDefLumps)
+	{
+		int lump, lastlump = 0;
+		while ((lump = fileSystem.FindLump(name, &lastlump)) != -1)
+		{
+			HashLump(md5, lump);
+		}
+	}
+	md5.Final(digest);
+}
+
+// Name indices are compiled into the code so all names that exist at this point must be the same.
+static void CalcNamesKey(uint8_t *digest)
+{
+	MD5Context md5;
+	for (int i = 0; i < StartNames; i++)
+	{
+		const char *name = FName(ENamedName(i)).GetChars();
+		md5.Update((const uint8_t *)name, (unsigned)strlen(name) + 1);
+	}
+	md5.Final(digest);
+}
+
+static FString ScriptCacheFileName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path);
+	path << "/scriptcache.zsc";
+	return path;
+}
+
+//==========================================================================
+//
+// CollectNames
+//
+// Names that are not unique are stored as nullptr so that they cannot
+// be resolved to the wrong object.
+//
+//==========================================================================
+
+template<class KT, class T>
+static void AddUnique(TMap<KT, T *> &map, const KT &name, T *ptr)
+{
+	auto check = map.CheckKey(name);
+	if (check == nullptr) map.Insert(name, ptr);
+	else if (*check != ptr) *check = nullptr;
+}
+
+static void CollectGlobals(FCacheNames &names, const char *owner, PSymbolTable &symbols)
+{
+	auto it = symbols.GetIterator();
+	PSymbolTable::MapType::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		auto field = dyn_cast<PField>(pair->Value);
+		if (field != nullptr && (field->Flags & VARF_Static) && field->Offset != 0)
+		{
+			FString name;
+			name.Format("%s.%s", owner, field->SymbolName.GetChars());
+			AddUnique(names.Globals, name, (void *)(intptr_t)field->Offset);
+		}
+	}
+}
+
+static void CollectNames(FCacheNames &names)
+{
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (func->PrintableName.IsNotEmpty()) AddUnique(names.Functions, func->PrintableName, func);
+	}
+	for (int i = 0; i < FTypeTable::HASH_SIZE; i++)
+	{
+		for (PType *type = TypeTable.TypeHash[i]; type != nullptr; type = type->HashNext)
+		{
+			FString name = type->DescriptiveName();
+			AddUnique(names.Types, name, type);
+			CollectGlobals(names, name, type->Symbols);
+		}
+	}
+	for (auto ns : Namespaces.AllNamespaces)
+	{
+		CollectGlobals(names, "", ns->Symbols);
+	}
+	for (auto rng = FRandom::StaticFirstRNG(); rng != nullptr; rng = rng->GetNext())
+	{
+		if (rng->GetNameCRC() != 0) AddUnique(names.RNGs, rng->GetNameCRC(), rng);
+	}
+}
+
+//==========================================================================
+//
+// BuildReverseMap
+//
+// Maps every pointer that may appear in a constant table to its name.
+//
+//==========================================================================
+
+static void AddRef(TMap<void *, FCacheRef> &map, void *ptr, uint8_t type, const FString &name, uint32_t index = 0)
+{
+	if (ptr == nullptr) return;
+	auto ref = map.CheckKey(ptr);
+	if (ref == nullptr) map.Insert(ptr, { type, name, index });
+	else if (ref->Type != type || ref->Name.Compare(name) != 0 || ref->Index != index) ref->Type = REF_Invalid;
+}
+
+static void BuildReverseMap(TMap<void *, FCacheRef> &map)
+{
+	FCacheNames names;
+	CollectNames(names);
+
+	for (auto cls : PClass::AllClasses)
+	{
+		AddRef(map, cls, REF_Class, cls->TypeName.GetChars());
+	}
+	for (auto cls : PClassActor::AllActorClasses)
+	{
+		auto states = cls->GetStates();
+		for (unsigned i = 0; i < cls->GetStateCount(); i++)
+		{
+			AddRef(map, states + i, REF_State, cls->TypeName.GetChars(), i);
+		}
+	}
+	{
+		TMap<FString, VMFunction *>::Iterator it(names.Functions);
+		TMap<FString, VMFunction *>::Pair *pair;
+		while (it.NextPair(pair)) AddRef(map, pair->Value, REF_Function, pair->Key);
+	}
+	{
+		TMap<FString, PType *>::Iterator it(names.Types);
+		TMap<FString, PType *>::Pair *pair;
+		while (it.NextPair(pair)) AddRef(map, pair->Value, REF_Type, pair->Key);
+	}
+	{
+		TMap<FString, void *>::Iterator it(names.Globals);
+		TMap<FString, void *>::Pair *pair;
+		while (it.NextPair(pair)) AddRef(map, pair->Value, REF_Global, pair->Key);
+	}
+	{
+		TMap<uint32_t, FRandom *>::Iterator it(names.RNGs);
+		TMap<uint32_t, FRandom *>::Pair *pair;
+		while (it.NextPair(pair)) AddRef(map, pair->Value, REF_Random, "", pair->Key);
+	}
+	for (auto cvar = CVars; cvar != nullptr; cvar = cvar->GetNext())
+	{
+		AddRef(map, FxCVar::GetValueAddress(cvar), REF_CVar, cvar->GetName());
+	}
+	AddRef(map, GetTextureCountAddress(), REF_TextureCount, "");
+}
+
+//==========================================================================
+//
+// WriteRef / ReadRef
+//
+//==========================================================================
+
+static bool WriteRef(FCacheWriter &wr, const void *ptr, TMap<void *, FCacheRef> &map, const FStoredFunction *stored)
+{
+	if ((uintptr_t)ptr < 0x10000)
+	{
+		// null or an offset, neither of which needs relocating.
+		wr.WriteUInt8(REF_Value);
+		wr.WriteUInt32((uint32_t)(uintptr_t)ptr);
+		return true;
+	}
+	if (stored != nullptr)
+	{
+		for (auto &block : stored->Data)
+		{
+			if (block.first == ptr)
+			{
+				wr.WriteUInt8(REF_Data);
+				wr.WriteUInt32(block.second);
+				wr.Write(block.first, block.second);
+				return true;
+			}
+		}
+	}
+	auto ref = map.CheckKey(const_cast<void *>(ptr));
+	if (ref == nullptr || ref->Type == REF_Invalid) return false;
+
+	wr.WriteUInt8(ref->Type);
+	switch (ref->Type)
+	{
+	case REF_State:
+		wr.WriteString(ref->Name);
+		wr.WriteUInt32(ref->Index);
+		break;
+
+	case REF_Random:
+		wr.WriteUInt32(ref->Index);
+		break;
+
+	case REF_TextureCount:
+		break;
+
+	default:
+		wr.WriteString(ref->Name);
+		break;
+	}
+	return true;
+}
+
+template<class T>
+static T *FindUnique(TMap<FString, T *> &map, const FString &name)
+{
+	auto check = map.CheckKey(name);
+	if (check == nullptr || *check == nullptr) I_Error("Cannot resolve '%s'", name.GetChars());
+	return *check;
+}
+
+static void *ReadRef(FCacheReader &rd)
+{
+	switch (rd.ReadUInt8())
+	{
+	case REF_Value:
+		return (void *)(uintptr_t)rd.ReadUInt32();
+
+	case REF_Class:
+	{
+		FString name = rd.ReadString();
+		auto cls = PClass::FindClass(name);
+		if (cls == nullptr) I_Error("Unknown class '%s'", name.GetChars());
+		return cls;
+	}
+
+	case REF_Type:
+		return FindUnique(LoadNames->Types, rd.ReadString());
+
+	case REF_Function:
+		return FindUnique(LoadNames->Functions, rd.ReadString());
+
+	case REF_Global:
+		return FindUnique(LoadNames->Globals, rd.ReadString());
+
+	case REF_State:
+	{
+		FString name = rd.ReadString();
+		unsigned index = rd.ReadUInt32();
+		auto cls = PClass::FindActor(name);
+		if (cls == nullptr || index >= cls->GetStateCount()) I_Error("Unknown state %s.%u", name.GetChars(), index);
+		return cls->GetStates() + index;
+	}
+
+	case REF_CVar:
+	{
+		FString name = rd.ReadString();
+		auto cvar = FindCVar(name, nullptr);
+		void *addr = cvar == nullptr ? nullptr : FxCVar::GetValueAddress(cvar);
+		if (addr == nullptr) I_Error("Unknown CVAR '%s'", name.GetChars());
+		return addr;
+	}
+
+	case REF_Random:
+	{
+		auto check = LoadNames->RNGs.CheckKey(rd.ReadUInt32());
+		if (check == nullptr || *check == nullptr) I_Error("Unknown random number generator");
+		return *check;
+	}
+
+	case REF_Data:
+	{
+		unsigned size = rd.ReadCount(1);
+		void *data = ClassDataAllocator.Alloc(size);
+		rd.Read(data, size);
+		return data;
+	}
+
+	case REF_TextureCount:
+		return GetTextureCountAddress();
+
+	default:
+		I_Error("Bad reference in script cache");
+		return nullptr;
+	}
+}
+
+//==========================================================================
+//
+// WriteFunction
+//
+// Returns false if the function references something that cannot be
+// relocated.
+//
+//==========================================================================
+
+static bool WriteFunction(FCacheWriter &wr, const FStoredFunction &stored, TMap<void *, FCacheRef> &map)
+{
+	auto func = stored.Function;
+
+	wr.WriteString(func->SourceFileName);
+	wr.WriteUInt8(func->Unsafe);
+	wr.WriteUInt32(func->ExtraSpace);
+	wr.WriteUInt8(func->NumRegD);
+	wr.WriteUInt8(func->NumRegF);
+	wr.WriteUInt8(func->NumRegS);
+	wr.WriteUInt8(func->NumRegA);
+	wr.WriteUInt32(func->MaxParam);
+
+	wr.WriteUInt32(func->CodeSize);
+	wr.Write(func->Code, func->CodeSize * sizeof(VMOP));
+	wr.WriteUInt32(func->LineInfoCount);
+	wr.Write(func->LineInfo, func->LineInfoCount * sizeof(FStatementInfo));
+	wr.WriteUInt32(func->NumKonstD);
+	wr.Write(func->KonstD, func->NumKonstD * sizeof(int));
+	wr.WriteUInt32(func->NumKonstF);
+	wr.Write(func->KonstF, func->NumKonstF * sizeof(double));
+	wr.WriteUInt32(func->NumKonstS);
+	for (int i = 0; i < func->NumKonstS; i++)
+	{
+		wr.WriteString(func->KonstS[i]);
+	}
+	wr.WriteUInt32(func->NumKonstA);
+	for (int i = 0; i < func->NumKonstA; i++)
+	{
+		if (!WriteRef(wr, func->KonstA[i].v, map, &stored)) return false;
+	}
+	wr.WriteUInt32(func->SpecialInits.Size());
+	for (auto &init : func->SpecialInits)
+	{
+		if (!WriteRef(wr, init.first, map, nullptr)) return false;
+		wr.WriteUInt32(init.second);
+	}
+
+	// Anonymous functions get their prototype from the return statements, so it must be recreated from the cache.
+	wr.WriteUInt8(stored.Anonymous);
+	if (stored.Anonymous)
+	{
+		auto &rets = func->Proto->ReturnTypes;
+		wr.WriteUInt32(rets.Size());
+		for (auto type : rets)
+		{
+			if (!WriteRef(wr, type, map, nullptr)) return false;
+		}
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// ReadCache
+//
+// Checks the cache file and adds the names and state labels the cached
+// code refers to by index.
+//
+//==========================================================================
+
+struct FCachedLabel
+{
+	FString Class;
+	unsigned Index;
+	TArray<FString> Names;
+};
+
+static bool ReadCache(unsigned numfunctions)
+{
+	try
+	{
+		FileReader fr;
+		if (!fr.OpenFile(ScriptCacheFileName(false))) return false;
+		CacheData = fr.Read();
+		FCacheReader rd(CacheData.Data(), CacheData.Size());
+
+		char magic[4];
+		uint8_t key[16];
+		rd.Read(magic, 4);
+		rd.Read(key, 16);
+		if (memcmp(magic, ScriptCacheMagic, 4) != 0 || memcmp(key, CacheKey, 16) != 0) return false;
+
+		// After a restart the names and labels from the previous compile still exist so their indices would not match.
+		// The file is still good for the next start, so it must not be replaced.
+		if ((int)rd.ReadUInt32() != StartNames || rd.ReadUInt32() != StartLabels)
+		{
+			CacheKeyMatched = true;
+			return false;
+		}
+		// Any other mismatch means the file is outdated, so it gets written again after this compile.
+		rd.Read(key, 16);
+		if (memcmp(key, NamesKey, 16) != 0) return false;
+
+		TArray<FString> names;
+		names.Resize(rd.ReadCount(4));
+		for (auto &name : names)
+		{
+			name = rd.ReadString();
+		}
+
+		TArray<FCachedLabel> labels;
+		labels.Resize(rd.ReadCount(4));
+		for (auto &label : labels)
+		{
+			label.Names.Resize(rd.ReadCount(4));
+			if (label.Names.Size() == 0)
+			{
+				label.Class = rd.ReadString();
+				label.Index = rd.ReadUInt32();
+			}
+			else for (auto &name : label.Names)
+			{
+				name = rd.ReadString();
+			}
+		}
+		unsigned endlabels = rd.ReadUInt32();
+
+		if (rd.ReadUInt32() != numfunctions) return false;
+		CachedFunctions.Resize(numfunctions);
+		for (auto &cached : CachedFunctions)
+		{
+			cached.Name = rd.ReadString();
+			cached.Size = rd.ReadUInt32();
+			cached.Offset = unsigned(rd.Skip(cached.Size) - CacheData.Data());
+		}
+
+		// The file is complete, so the names and labels can be added now.
+		for (unsigned i = 0; i < names.Size(); i++)
+		{
+			if (FName(names[i]).GetIndex() != StartNames + (int)i) return false;
+		}
+		for (auto &label : labels)
+		{
+			if (label.Names.Size() == 0)
+			{
+				auto cls = PClass::FindActor(label.Class);
+				if (cls == nullptr || label.Index >= cls->GetStateCount()) return false;
+				StateLabels.AddPointer(cls->GetStates() + label.Index);
+			}
+			else
+			{
+				TArray<FName> labelnames;
+				for (auto &name : label.Names) labelnames.Push(FName(name));
+				StateLabels.AddNames(labelnames);
+			}
+		}
+		return StateLabels.Storage.Size() == endlabels;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+//==========================================================================
+//
+// WriteCache
+//
+//==========================================================================
+
+static void WriteCache()
+{
+	TMap<void *, FCacheRef> refs;
+	BuildReverseMap(refs);
+
+	FCacheWriter wr;
+	wr.Write(ScriptCacheMagic, 4);
+	wr.Write(CacheKey, 16);
+	wr.WriteUInt32(StartNames);
+	wr.WriteUInt32(StartLabels);
+	wr.Write(NamesKey, 16);
+
+	int numnames = FName::GetNumNames();
+	wr.WriteUInt32(numnames - StartNames);
+	for (int i = StartNames; i < numnames; i++)
+	{
+		wr.WriteString(FName(ENamedName(i)).GetChars());
+	}
+
+	// Same layout as FStateLabelStorage: a count of 0 is followed by a state pointer, otherwise by that many names.
+	auto &storage = StateLabels.Storage;
+	FCacheWriter labels;
+	unsigned numlabels = 0;
+	for (unsigned pos = StartLabels; pos < storage.Size(); numlabels++)
+	{
+		int count;
+		memcpy(&count, &storage[pos], sizeof(int));
+		pos += sizeof(int);
+		labels.WriteUInt32(count);
+		if (count == 0)
+		{
+			FState *state;
+			memcpy(&state, &storage[pos], sizeof(state));
+			pos += sizeof(state);
+			auto ref = refs.CheckKey(state);
+			if (ref == nullptr || ref->Type != REF_State) return;
+			labels.WriteString(ref->Name);
+			labels.WriteUInt32(ref->Index);
+		}
+		else for (int i = 0; i < count; i++)
+		{
+			FName name;
+			memcpy(&name, &storage[pos], sizeof(FName));
+			pos += sizeof(FName);
+			labels.WriteString(name.GetChars());
+		}
+	}
+	wr.WriteUInt32(numlabels);
+	wr.Write(labels.Data.Data(), labels.Data.Size());
+	wr.WriteUInt32(storage.Size());
+
+	unsigned numcached = 0;
+	wr.WriteUInt32(StoredFunctions.Size());
+	for (auto &stored : StoredFunctions)
+	{
+		FCacheWriter func;
+		if (stored.Function != nullptr && WriteFunction(func, stored, refs))
+		{
+			wr.WriteString(stored.Function->PrintableName);
+			wr.WriteUInt32(func.Data.Size());
+			wr.Write(func.Data.Data(), func.Data.Size());
+			numcached++;
+		}
+		else
+		{
+			wr.WriteString(stored.Function != nullptr ? stored.Function->PrintableName : FString());
+			wr.WriteUInt32(0);
+		}
+	}
+
+	FString path = ScriptCacheFileName(true);
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(path));
+	if (fw)
+	{
+		bool success = fw->Write(wr.Data.Data(), wr.Data.Size()) == wr.Data.Size();
+		fw.reset();
+		if (!success) remove(path);
+		else DPrintf(DMSG_NOTIFY, "Script cache: stored %u of %u functions\n", numcached, StoredFunctions.Size());
+	}
+}
+
+//==========================================================================
+//
+// ScriptCacheBegin
+//
+//==========================================================================
+
+void ScriptCacheBegin(unsigned numfunctions)
+{
+	CacheLoaded = CacheKeyMatched = false;
+	NumLoaded = 0;
+	CacheActive = vm_scriptcache && !Args->CheckParm("-noscriptcache");
+	if (!CacheActive) return;
+
+	StartNames = FName::GetNumNames();
+	StartLabels = StateLabels.Storage.Size();
+	CalcCacheKey(CacheKey);
+	CalcNamesKey(NamesKey);
+	StoredFunctions.Resize(numfunctions);
+	CacheLoaded = ReadCache(numfunctions);
+	if (!CacheLoaded)
+	{
+		CacheData.Reset();
+		CachedFunctions.Reset();
+	}
+}
+
+//==========================================================================
+//
+// ScriptCacheLoad
+//
+// Fills in the function from the cache. Returns false if it needs to
+// be compiled.
+//
+//==========================================================================
+
+bool ScriptCacheLoad(unsigned index, VMScriptFunction *func, PFunction *pfunc)
+{
+	if (!CacheLoaded || index >= CachedFunctions.Size()) return false;
+	auto &cached = CachedFunctions[index];
+	if (cached.Size == 0 || cached.Name.Compare(func->PrintableName) != 0) return false;
+
+	if (LoadNames == nullptr)
+	{
+		LoadNames.reset(new FCacheNames);
+		CollectNames(*LoadNames);
+	}
+
+	try
+	{
+		FCacheReader rd(&CacheData[cached.Offset], cached.Size);
+
+		FString sourcefile = rd.ReadString();
+		bool unsafe = !!rd.ReadUInt8();
+		int extraspace = rd.ReadUInt32();
+		VM_UBYTE numregs[4];
+		rd.Read(numregs, 4);
+		unsigned maxparam = rd.ReadUInt32();
+
+		unsigned numops = rd.ReadCount(sizeof(VMOP));
+		auto code = rd.Skip(numops * sizeof(VMOP));
+		unsigned numlines = rd.ReadCount(sizeof(FStatementInfo));
+		auto lines = rd.Skip(numlines * sizeof(FStatementInfo));
+		unsigned numkd = rd.ReadCount(sizeof(int));
+		auto konstd = rd.Skip(numkd * sizeof(int));
+		unsigned numkf = rd.ReadCount(sizeof(double));
+		auto konstf = rd.Skip(numkf * sizeof(double));
+
+		TArray<FString> konsts;
+		konsts.Resize(rd.ReadCount(4));
+		for (auto &str : konsts) str = rd.ReadString();
+
+		TArray<void *> konsta;
+		konsta.Resize(rd.ReadCount(1));
+		for (auto &ptr : konsta) ptr = ReadRef(rd);
+
+		TArray<FTypeAndOffset> inits;
+		inits.Resize(rd.ReadCount(5));
+		for (auto &init : inits)
+		{
+			init.first = (PType *)ReadRef(rd);
+			init.second = rd.ReadUInt32();
+		}
+
+		TArray<PType *> rets;
+		bool anonymous = !!rd.ReadUInt8();
+		if (anonymous)
+		{
+			rets.Resize(rd.ReadCount(1));
+			for (auto &type : rets) type = (PType *)ReadRef(rd);
+		}
+
+		if (numops == 0 || numkd > 65535 || numkf > 65535 || konsts.Size() > 65535 || konsta.Size() > 65535) return false;
+
+		func->Alloc(numops, numkd, numkf, konsts.Size(), konsta.Size(), numlines);
+		memcpy(func->Code, code, numops * sizeof(VMOP));
+		if (numlines > 0) memcpy(func->LineInfo, lines, numlines * sizeof(FStatementInfo));
+		if (numkd > 0) memcpy(func->KonstD, konstd, numkd * sizeof(int));
+		if (numkf > 0) memcpy(func->KonstF, konstf, numkf * sizeof(double));
+		for (unsigned i = 0; i < konsts.Size(); i++) func->KonstS[i] = konsts[i];
+		for (unsigned i = 0; i < konsta.Size(); i++) func->KonstA[i].v = konsta[i];
+
+		func->SourceFileName = sourcefile;
+		func->Unsafe = unsafe;
+		func->ExtraSpace = extraspace;
+		func->SpecialInits = std::move(inits);
+		func->NumRegD = numregs[0];
+		func->NumRegF = numregs[1];
+		func->NumRegS = numregs[2];
+		func->NumRegA = numregs[3];
+		func->MaxParam = maxparam;
+		func->StackSize = VMFrame::FrameSize(func->NumRegD, func->NumRegF, func->NumRegS, func->NumRegA, func->MaxParam, func->ExtraSpace);
+
+		if (anonymous && func->Proto == nullptr)
+		{
+			func->Proto = NewPrototype(rets, pfunc->Variants[0].Proto->ArgumentTypes);
+			func->ArgFlags = pfunc->Variants[0].ArgFlags;
+		}
+		NumLoaded++;
+		return true;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+//==========================================================================
+//
+// ScriptCacheStore
+//
+//==========================================================================
+
+void ScriptCacheStore(unsigned index, VMScriptFunction *func, bool anonymous, const VMFunctionBuilder &build)
+{
+	if (!CacheActive || CacheLoaded || CacheKeyMatched || index >= StoredFunctions.Size()) return;
+
+	auto &stored = StoredFunctions[index];
+	stored.Function = func;
+	stored.Anonymous = anonymous;
+	stored.Data = build.ConstantData;
+}
+
+//==========================================================================
+//
+// ScriptCacheEnd
+//
+// Writes a new cache if nothing was loaded and the compile succeeded.
+//
+//==========================================================================
+
+void ScriptCacheEnd()
+{
+	if (CacheActive)
+	{
+		if (CacheLoaded)
+		{
+			DPrintf(DMSG_NOTIFY, "Script cache: loaded %u of %u functions\n", NumLoaded, CachedFunctions.Size());
+		}
+		else if (!CacheKeyMatched && FScriptPosition::ErrorCounter == 0)
+		{
+			WriteCache();
+		}
+	}
+	CacheActive = CacheLoaded = CacheKeyMatched = false;
+	CacheData.Reset();
+	CachedFunctions.Reset();
+	StoredFunctions.Reset();
+	ScriptCacheLumps.Reset();
+	LoadNames.reset();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "vmbuilder.h"
+
+class PFunction;
+
+// Remembers a lump that was parsed as script code. Its contents are part of the cache key.
+void ScriptCacheAddLump(int lump);
+
+// Called by FFunctionBuildList::Build around compiling the function bodies.
+void ScriptCacheBegin(unsigned numfunctions);
+bool ScriptCacheLoad(unsigned index, VMScriptFunction *func, PFunction *pfunc);
+void ScriptCacheStore(unsigned index, VMScriptFunction *func, bool anonymous, const VMFunctionBuilder &build);
+void ScriptCacheEnd();
@@ -34,6 +34,7 @@
 
 #include "vmbuilder.h"
 #include "codegen.h"
+#include "scriptcache.h"
 #include "m_argv.h"
 #include "c_cvars.h"
 #include "scripting/vm/jit.h"
@@ -289,6 +290,23 @@ unsigned VMFunctionBuilder::GetConstantAddress(void *ptr)
 	}
 }
 
+//==========================================================================
+//
+// VMFunctionBuilder :: GetConstantData
+//
+// Copies the data into the class data arena so that the pointer does not
+// need to be maintained, and returns a constant register pointing to it.
+//
+//==========================================================================
+
+unsigned VMFunctionBuilder::GetConstantData(const void *data, unsigned size)
+{
+	void *copy = ClassDataAllocator.Alloc(size);
+	memcpy(copy, data, size);
+	ConstantData.Push(std::make_pair(copy, size));
+	return GetConstantAddress(copy);
+}
+
 //==========================================================================
 //
 // VMFunctionBuilder :: AllocConstants*
@@ -809,14 +827,54 @@ VMFunction *FFunctionBuildList::AddFunction(PNamespace *gnspc, const VersionInfo
 }
 
 
+//==========================================================================
+//
+// NumArgs for the VMFunction must be the amount of stack elements, which can differ from the amount of logical function arguments if vectors are in the list.
+// For the VM a vector is 2 or 3 args, depending on size.
+//
+//==========================================================================
+
+static int CountStackArgs(PFunction *func)
+{
+	int numargs = 0;
+	auto &funcVariant = func->Variants[0];
+	for (unsigned int i = 0; i < funcVariant.Proto->ArgumentTypes.Size(); i++)
+	{
+		auto argType = funcVariant.Proto->ArgumentTypes[i];
+		auto argFlags = funcVariant.ArgFlags[i];
+		if (argFlags & VARF_Out)
+		{
+			auto argPointer = NewPointer(argType);
+			numargs += argPointer->GetRegCount();
+		}
+		else
+		{
+			numargs += argType->GetRegCount();
+		}
+	}
+	return numargs;
+}
+
 void FFunctionBuildList::Build()
 {
 	VMDisassemblyDumper disasmdump(VMDisassemblyDumper::Overwrite);
 
-	for (auto &item : mItems)
+	ScriptCacheBegin(mItems.Size());
+	for (unsigned index = 0; index < mItems.Size(); index++)
 	{
+		auto &item = mItems[index];
 		assert(item.Code != NULL);
 
+		// If this function's code was cached by an earlier run there's nothing left to resolve or emit.
+		if (ScriptCacheLoad(index, item.Function, item.Func))
+		{
+			item.Function->NumArgs = CountStackArgs(item.Func);
+			disasmdump.Write(item.Function, item.PrintableName);
+			delete item.Code;
+			disasmdump.Flush();
+			continue;
+		}
+
 		// We don't know the return type in advance for anonymous functions.
 		FCompileContext ctx(item.CurGlobals, item.Func, item.Func->SymbolName == NAME_None ? nullptr : item.Func->Variants[0].Proto, item.FromDecorate, item.StateIndex, item.StateCount, item.Lump, item.Version);
 
@@ -879,28 +937,12 @@ void FFunctionBuildList::Build()
 				item.Code->Emit(&buildit);
 				buildit.EndStatement();
 				buildit.MakeFunction(sfunc);
-				sfunc->NumArgs = 0;
-				// NumArgs for the VMFunction must be the amount of stack elements, which can differ from the amount of logical function arguments if vectors are in the list.
-				// For the VM a vector is 2 or 3 args, depending on size.
-				auto funcVariant = item.Func->Variants[0];
-				for (unsigned int i = 0; i < funcVariant.Proto->ArgumentTypes.Size(); i++)
-				{
-					auto argType = funcVariant.Proto->ArgumentTypes[i];
-					auto argFlags = funcVariant.ArgFlags[i];
-					if (argFlags & VARF_Out)
-					{
-						auto argPointer = NewPointer(argType);
-						sfunc->NumArgs += argPointer->GetRegCount();
-					}
-					else
-					{
-						sfunc->NumArgs += argType->GetRegCount();
-					}
-				}
+				sfunc->NumArgs = CountStackArgs(item.Func);
 
 				disasmdump.Write(sfunc, item.PrintableName);
 
 				sfunc->Unsafe = ctx.Unsafe;
+				ScriptCacheStore(index, sfunc, item.Func->SymbolName == NAME_None, buildit);
 			}
 			catch (CRecoverableError &err)
 			{
@@ -911,6 +953,7 @@ void FFunctionBuildList::Build()
 		delete item.Code;
 		disasmdump.Flush();
 	}
+	ScriptCacheEnd();
 	VMFunction::CreateRegUseInfo();
 	FScriptPosition::StrictErrors = strictdecorate;
 
@@ -1065,9 +1108,7 @@ ExpEmit FunctionCallEmitter::EmitCall(VMFunctionBuilder *build, TArray<ExpEmit>
 	{
 		// Pass a hidden type information parameter to vararg functions.
 		// It would really be nicer to actually pass real types but that'd require a far more complex interface on the compiler side than what we have.
-		uint8_t *regbuffer = (uint8_t*)ClassDataAllocator.Alloc(reginfo.Size());	// Allocate in the arena so that the pointer does not need to be maintained.
-		memcpy(regbuffer, reginfo.Data(), reginfo.Size());
-		build->Emit(OP_PARAM, REGT_POINTER | REGT_KONST, build->GetConstantAddress(regbuffer));
+		build->Emit(OP_PARAM, REGT_POINTER | REGT_KONST, build->GetConstantData(reginfo.Data(), reginfo.Size()));
 		paramcount++;
 	}
 
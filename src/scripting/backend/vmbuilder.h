@@ -64,6 +64,7 @@ public:
 	unsigned GetConstantFloat(double val);
 	unsigned GetConstantAddress(void *ptr);
 	unsigned GetConstantString(FString str);
+	unsigned GetConstantData(const void *data, unsigned size);
 
 	unsigned AllocConstantsInt(unsigned int count, int *values);
 	unsigned AllocConstantsFloat(unsigned int count, double *values);
@@ -105,6 +106,9 @@ public:
 	ExpEmit FramePointer;
 	TArray<FxLocalVariableDeclaration *> ConstructedStructs;
 
+	// Data blocks created by GetConstantData. The script cache needs to know their size.
+	TArray<std::pair<void *, unsigned>> ConstantData;
+
 private:
 	TArray<FStatementInfo> LineNumbers;
 	TArray<FxExpression *> StatementStack;
@@ -44,6 +44,7 @@
 #include "thingdef.h"
 #include "a_morph.h"
 #include "backend/codegen.h"
+#include "backend/scriptcache.h"
 #include "filesystem.h"
 #include "v_text.h"
 #include "m_argv.h"
@@ -1256,6 +1257,8 @@ static void ParseDamageDefinition(FScanner &sc)
 
 void ParseDecorate (FScanner &sc, PNamespace *ns)
 {
+	ScriptCacheAddLump(sc.LumpNum);
+
 	// Get actor class name.
 	for(;;)
 	{
@@ -8,7 +8,7 @@ extern PStruct *TypeVector3;
 
 static void OutputJitLog(const asmjit::StringLogger &logger);
 
-JitFuncPtr JitCompile(VMScriptFunction *sfunc)
+JitFuncPtr JitCompile(VMScriptFunction *sfunc, FString *log)
 {
 #if 0
 	if (strcmp(sfunc->PrintableName.GetChars(), "StatusScreen.drawNum") != 0)
@@ -16,6 +16,7 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 #endif
 
 	using namespace asmjit;
+	std::lock_guard<std::mutex> lock(JitMutex);
 	StringLogger logger;
 	try
 	{
@@ -30,15 +31,33 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 	}
 	catch (const CRecoverableError &e)
 	{
+		if (log != nullptr)
+		{
+			log->AppendFormat("%s%s: Unexpected JIT error: %s\n", logger.getString(), sfunc->PrintableName.GetChars(), e.what());
+			return nullptr;
+		}
 		OutputJitLog(logger);
 		Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName.GetChars(), e.what());
 		return nullptr;
 	}
+	catch (const std::exception &e)
+	{
+		if (log == nullptr) throw;
+		log->AppendFormat("%s%s: Unexpected JIT error: %s\n", logger.getString(), sfunc->PrintableName.GetChars(), e.what());
+		return nullptr;
+	}
+	catch (...)
+	{
+		if (log == nullptr) throw;
+		log->AppendFormat("%s: Unexpected JIT error\n", sfunc->PrintableName.GetChars());
+		return nullptr;
+	}
 }
 
 void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 {
 	using namespace asmjit;
+	std::lock_guard<std::mutex> lock(JitMutex);
 	StringLogger logger;
 	try
 	{
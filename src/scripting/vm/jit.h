@@ -3,6 +3,8 @@
 
 #include "vmintern.h"
 
-JitFuncPtr JitCompile(VMScriptFunction *func);
+// If log is set, the function is compiled for a worker thread: nothing gets printed
+// and no error escapes. All output and error messages go to the log instead.
+JitFuncPtr JitCompile(VMScriptFunction *func, FString *log = nullptr);
 void JitDumpLog(FILE *file, VMScriptFunction *func);
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames);
@@ -22,6 +22,7 @@ struct JitFuncInfo
 	void *end;
 };
 
+std::mutex JitMutex;
 static TArray<JitFuncInfo> JitDebugInfo;
 static TArray<uint8_t*> JitBlocks;
 static TArray<uint8_t*> JitFrames;
@@ -737,6 +738,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 void JitRelease()
 {
+	std::lock_guard<std::mutex> lock(JitMutex);
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -961,6 +963,7 @@ FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames)
 	if (includeNativeFrames)
 		nativeSymbols.reset(new NativeSymbolResolver());
 
+	std::lock_guard<std::mutex> lock(JitMutex);
 	FString s;
 	for (int i = framesToSkip + 1; i < numframes; i++)
 	{
@@ -12,6 +12,7 @@
 #include <asmjit/x86.h>
 #include <functional>
 #include <vector>
+#include <mutex>
 
 extern cycle_t VMCycles[10];
 extern int VMCalls[10];
@@ -334,4 +335,7 @@ public:
 };
 
 void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler);
+
+// Functions get compiled on a background thread. This guards the compiler and the list of compiled functions.
+extern std::mutex JitMutex;
 asmjit::CodeInfo GetHostCodeInfo();
@@ -55,6 +55,7 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void JitCancelBackground();
 
 
 typedef unsigned char		VM_UBYTE;
@@ -428,6 +429,8 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		// nothing may be compiling while the functions get deleted.
+		JitCancelBackground();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
@@ -777,6 +780,20 @@ unsigned GetVirtualIndex(PClass *cls, const char *funcname);
 
 #define IFVIRTUAL(cls, funcname) IFVIRTUALPTR(this, cls, funcname)
 
+// Only goes through the VM if a subclass has overridden the function. The base class's version must be
+// a native wrapper around the C++ method so that the else branch can call that directly without marshalling the parameters.
+#define IFOVERRIDENVIRTUALPTR(self, cls, funcname) \
+	static unsigned VIndex = ~0u; \
+	if (VIndex == ~0u) { \
+		VIndex = GetVirtualIndex(RUNTIME_CLASS(cls), #funcname); \
+		assert(VIndex != ~0u); \
+	} \
+	auto clss = self->GetClass(); \
+	VMFunction *func = clss->Virtuals.Size() > VIndex? clss->Virtuals[VIndex] : nullptr;  \
+	if (func != nullptr && func != RUNTIME_CLASS(cls)->Virtuals[VIndex])
+
+#define IFOVERRIDENVIRTUAL(cls, funcname) IFOVERRIDENVIRTUALPTR(this, cls, funcname)
+
 #define IFVIRTUALPTRNAME(self, cls, funcname) \
 	static unsigned VIndex = ~0u; \
 	if (VIndex == ~0u) { \
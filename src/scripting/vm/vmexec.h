@@ -550,6 +550,7 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		}
 		NEXTOP;
 	OP(JMP):
+		if (JMPOFS(pc) < 0) sfunc->HotCount++;	// loops count towards getting the function JIT compiled.
 		pc += JMPOFS(pc);
 		NEXTOP;
 	OP(IJMP):
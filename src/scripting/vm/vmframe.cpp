@@ -33,6 +33,7 @@
 */
 
 #include <new>
+#include <mutex>
 #include "dobject.h"
 #include "v_text.h"
 #include "stats.h"
@@ -43,6 +44,8 @@
 #include "jit.h"
 #include "c_cvars.h"
 #include "version.h"
+#include "i_time.h"
+#include "ctpl.h"
 
 #ifdef HAVE_VM_JIT
 CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
@@ -50,10 +53,13 @@ CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
 	Printf("You must restart " GAMENAME " for this change to take effect.\n");
 	Printf("This cvar is currently not saved. You must specify it on the command line.");
 }
+// Number of calls and loop iterations after which a function gets compiled. 0 compiles everything on its first call.
+CVAR(Int, vm_jitthreshold, 100, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 #else
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames) { return FString(); }
 void JitRelease() {}
+void JitCancelBackground() {}
 #endif
 
 cycle_t VMCycles[10];
@@ -278,11 +284,130 @@ static bool CanJit(VMScriptFunction *func)
 	return false;
 }
 
+#ifdef HAVE_VM_JIT
+
+//==========================================================================
+//
+// Background JIT compilation
+//
+// Functions start out interpreted and are only compiled once they have
+// been used a lot. The compile runs on a worker thread so that a monster
+// or weapon showing up for the first time does not stall the frame.
+//
+//==========================================================================
+
+static ctpl::thread_pool JitPool;
+static std::atomic<bool> JitCancel;
+static std::atomic<int> JitPending;
+static std::atomic<int> JitInterpreted;
+static std::atomic<int> JitCompiled;
+static std::atomic<int> JitFailed;
+static std::atomic<uint64_t> JitCompileTime;
+
+// Messages from the worker. Printf may only be called from the main thread.
+static std::mutex JitMessageMutex;
+static TArray<FString> JitMessages;
+static std::atomic<bool> JitHasMessages;
+
+static void JitFlushMessages()
+{
+	std::lock_guard<std::mutex> lock(JitMessageMutex);
+	for (auto &msg : JitMessages)
+	{
+		Printf("%s", msg.GetChars());
+	}
+	JitMessages.Clear();
+	JitHasMessages = false;
+}
+
+static void JitQueue(VMScriptFunction *sfunc)
+{
+	if (JitPool.size() == 0)
+	{
+		JitPool.resize(1);
+	}
+	JitInterpreted--;
+	JitPending++;
+	JitPool.push([=](int)
+	{
+		// JitCancelBackground waits for this, so it must go down no matter how the compile ends.
+		struct FPendingGuard { ~FPendingGuard() { JitPending--; } } guard;
+
+		if (JitCancel) return;
+
+		JitFuncPtr code = nullptr;
+		FString log;
+		try
+		{
+			uint64_t start = I_nsTime();
+			code = JitCompile(sfunc, &log);
+			JitCompileTime += I_nsTime() - start;
+		}
+		catch (...)
+		{
+			log.AppendFormat("%s: Unexpected JIT error\n", sfunc->PrintableName.GetChars());
+		}
+		if (code != nullptr) JitCompiled++;
+		else JitFailed++;
+		sfunc->JitCode.store(code != nullptr ? code : VMExec, std::memory_order_release);
+
+		if (log.IsNotEmpty())
+		{
+			std::lock_guard<std::mutex> lock(JitMessageMutex);
+			JitMessages.Push(log);
+			JitHasMessages = true;
+		}
+	});
+}
+
+void JitCancelBackground()
+{
+	JitCancel = true;
+	while (JitPending > 0)
+	{
+		std::this_thread::yield();
+	}
+	JitCancel = false;
+	JitFlushMessages();
+	JitInterpreted = 0;
+	JitCompiled = 0;
+	JitFailed = 0;
+	JitCompileTime = 0;
+}
+
+int VMScriptFunction::TieredScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	if (JitHasMessages) JitFlushMessages();
+
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	auto code = sfunc->JitCode.load(std::memory_order_acquire);
+	if (code != nullptr)
+	{
+		// The compile has finished so from now on this goes straight to the native code.
+		func->ScriptCall = code;
+		return code(func, params, numparams, ret, numret);
+	}
+	if (!sfunc->JitQueued && ++sfunc->HotCount >= (unsigned)vm_jitthreshold)
+	{
+		sfunc->JitQueued = true;
+		JitQueue(sfunc);
+	}
+	return VMExec(func, params, numparams, ret, numret);
+}
+
+#endif // HAVE_VM_JIT
+
 int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
 {
 #ifdef HAVE_VM_JIT
 	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
 	{
+		if (vm_jitthreshold > 0)
+		{
+			JitInterpreted++;
+			func->ScriptCall = &VMScriptFunction::TieredScriptCall;
+			return TieredScriptCall(func, params, numparams, ret, numret);
+		}
 		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
 		if (!func->ScriptCall)
 			func->ScriptCall = VMExec;
@@ -393,7 +518,10 @@ VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 	frame->NumRegS = func->NumRegS;
 	frame->NumRegA = func->NumRegA;
 	frame->MaxParam = func->MaxParam;
-	frame->Func = func;
+	frame->NumParam = 0;
+	// The parameter stack is always written before it is read, so only the registers and the extra space need clearing.
+	uint8_t *regs = (uint8_t *)frame->GetRegF();
+	memset(regs, 0, (uint8_t *)frame + func->StackSize - regs);
 	frame->InitRegS();
 	if (func->SpecialInits.Size())
 	{
@@ -407,7 +535,7 @@ VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 // VMFrameStack :: Alloc
 //
 // Allocates space for a frame. Its size will be rounded up to a multiple
-// of 16 bytes.
+// of 16 bytes. Apart from the parent link the contents are not initialized.
 //
 //===========================================================================
 
@@ -456,7 +584,6 @@ VMFrame *VMFrameStack::Alloc(int size)
 		Blocks = block;
 	}
 	frame = (VMFrame *)block->FreeSpace;
-	memset(frame, 0, size);
 	frame->ParentFrame = parent;
 	block->FreeSpace += size;
 	block->LastFrame = frame;
@@ -738,7 +865,16 @@ ADD_STAT(VM)
 	memmove(&VMCalls[1], &VMCalls[0], 9 * sizeof(int));
 	VMCycles[0].Reset();
 	VMCalls[0] = 0;
-	return FStringf("VM time in last 10 tics: %f ms, %d calls, peak = %f ms", added, addedc, peak);
+	FString out;
+	out.Format("VM time in last 10 tics: %f ms, %d calls, peak = %f ms", added, addedc, peak);
+#ifdef HAVE_VM_JIT
+	if (vm_jit)
+	{
+		out.AppendFormat("\nJIT: %d compiled in %.1f ms, %d interpreted, %d queued, %d failed",
+			JitCompiled.load(), JitCompileTime.load() / 1e6, JitInterpreted.load(), JitPending.load(), JitFailed.load());
+	}
+#endif
+	return out;
 }
 
 //-----------------------------------------------------------------------------
@@ -2,6 +2,7 @@
 
 #include "vm.h"
 #include <csetjmp>
+#include <atomic>
 
 class VMScriptFunction;
 
@@ -361,7 +362,7 @@ public:
 	}
 	static int OffsetLastFrame() { return (int)(ptrdiff_t)offsetof(BlockHeader, LastFrame); }
 private:
-	enum { BLOCK_SIZE = 4096 };		// Default block size
+	enum { BLOCK_SIZE = 65536 };	// Default block size. Large enough that normal call chains never need a second block.
 	struct BlockHeader
 	{
 		BlockHeader *NextBlock;
@@ -472,6 +473,9 @@ public:
 	VM_UHALF MaxParam;		// Maximum number of parameters this function has on the stack at once
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
+	unsigned HotCount = 0;		// calls and backward jumps while interpreted. Once this gets high enough the function is JIT compiled.
+	bool JitQueued = false;
+	std::atomic<JitFuncPtr> JitCode { nullptr };	// Set by the background compile. The function switches over on its next call.
 
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
@@ -480,4 +484,5 @@ public:
 
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+	static int TieredScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
 };
@@ -40,6 +40,7 @@
 #include "version.h"
 #include "zcc_parser.h"
 #include "zcc_compile.h"
+#include "backend/scriptcache.h"
 
 TArray<FString> Includes;
 TArray<FScriptPosition> IncludeLocs;
@@ -263,6 +264,7 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 	FScanner &sc = *pSC;
 	sc.SetParseVersion(state.ParseVersion);
 	state.sc = &sc;
+	ScriptCacheAddLump(sc.LumpNum);
 
 	while (sc.GetToken())
 	{
@@ -60,6 +60,7 @@
 #include "cmdlib.h"
 #include "g_levellocals.h"
 #include "utf8.h"
+#include "superfasthash.h"
 
 bool save_full = false;	// for testing. Should be removed afterward.
 
@@ -139,6 +140,306 @@ struct FJSONObject
 	}
 };
 
+//==========================================================================
+//
+// Binary savegame format
+//
+// A stream of tagged values that maps 1:1 onto the JSON structure.
+// Integers are varints, doubles are stored raw and keys are interned,
+// so each key's name is only stored the first time it occurs.
+// The reader replays the stream into a JSON DOM, so everything
+// that reads from a serializer works the same for both formats.
+//
+//==========================================================================
+
+static const char BinaryMagic[4] = { 'G', 'Z', 'B', 'S' };
+
+enum EBinaryTag : uint8_t
+{
+	BT_Null,
+	BT_False,
+	BT_True,
+	BT_Int,			// varint
+	BT_NegInt,		// varint of -(value+1)
+	BT_Double,		// 8 bytes, little endian
+	BT_String,		// varint length + characters
+	BT_Key,			// varint index of an interned key
+	BT_NewKey,		// varint length + characters, gets the next key index
+	BT_StartObject,
+	BT_EndObject,
+	BT_StartArray,
+	BT_EndArray,
+};
+
+struct FBinaryWriter
+{
+	TArray<uint8_t> mBuffer;
+	TArray<char> mKeyNames;
+	TArray<unsigned> mKeyOffsets;
+	TArray<int> mKeyHash;
+
+	FBinaryWriter()
+	{
+		mBuffer.Grow(0x10000);
+		Bytes(BinaryMagic, sizeof(BinaryMagic));
+		mKeyHash.Resize(256);
+		memset(mKeyHash.Data(), -1, mKeyHash.Size() * sizeof(int));
+	}
+
+	void Tag(EBinaryTag t)
+	{
+		mBuffer.Push(t);
+	}
+
+	void VarInt(uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			mBuffer.Push(uint8_t(v | 0x80));
+			v >>= 7;
+		}
+		mBuffer.Push(uint8_t(v));
+	}
+
+	void Bytes(const char *k, size_t len)
+	{
+		if (len == 0) return;
+		unsigned pos = mBuffer.Reserve((unsigned)len);
+		memcpy(&mBuffer[pos], k, len);
+	}
+
+	void Chars(const char *k, size_t len)
+	{
+		VarInt(len);
+		Bytes(k, len);
+	}
+
+	void StartObject() { Tag(BT_StartObject); }
+	void EndObject() { Tag(BT_EndObject); }
+	void StartArray() { Tag(BT_StartArray); }
+	void EndArray() { Tag(BT_EndArray); }
+	void Null() { Tag(BT_Null); }
+	void Bool(bool k) { Tag(k ? BT_True : BT_False); }
+
+	void String(const char *k)
+	{
+		Tag(BT_String);
+		Chars(k, strlen(k));
+	}
+
+	void Int64(int64_t k)
+	{
+		if (k >= 0)
+		{
+			Tag(BT_Int);
+			VarInt(uint64_t(k));
+		}
+		else
+		{
+			Tag(BT_NegInt);
+			VarInt(~uint64_t(k));
+		}
+	}
+
+	void Uint64(uint64_t k)
+	{
+		Tag(BT_Int);
+		VarInt(k);
+	}
+
+	void Double(double k)
+	{
+		uint64_t v;
+		memcpy(&v, &k, sizeof(v));
+		Tag(BT_Double);
+		for (int i = 0; i < 8; i++, v >>= 8)
+		{
+			mBuffer.Push(uint8_t(v));
+		}
+	}
+
+	void Key(const char *k)
+	{
+		size_t len = strlen(k);
+		unsigned mask = mKeyHash.Size() - 1;
+		unsigned slot = SuperFastHash(k, len) & mask;
+
+		for (int index; (index = mKeyHash[slot]) >= 0; slot = (slot + 1) & mask)
+		{
+			if (!strcmp(&mKeyNames[mKeyOffsets[index]], k))
+			{
+				Tag(BT_Key);
+				VarInt(index);
+				return;
+			}
+		}
+
+		mKeyHash[slot] = mKeyOffsets.Push(mKeyNames.Size());
+		memcpy(&mKeyNames[mKeyNames.Reserve((unsigned)len + 1)], k, len + 1);
+		Tag(BT_NewKey);
+		Chars(k, len);
+
+		if (mKeyOffsets.Size() * 2 > mKeyHash.Size()) Rehash();
+	}
+
+	void Rehash()
+	{
+		mKeyHash.Resize(mKeyHash.Size() * 2);
+		memset(mKeyHash.Data(), -1, mKeyHash.Size() * sizeof(int));
+		unsigned mask = mKeyHash.Size() - 1;
+		for (unsigned i = 0; i < mKeyOffsets.Size(); i++)
+		{
+			const char *k = &mKeyNames[mKeyOffsets[i]];
+			unsigned slot = SuperFastHash(k, strlen(k)) & mask;
+			while (mKeyHash[slot] >= 0) slot = (slot + 1) & mask;
+			mKeyHash[slot] = i;
+		}
+	}
+};
+
+//==========================================================================
+//
+// Feeds a binary stream into a RapidJSON document as SAX events.
+//
+//==========================================================================
+
+class FBinaryReader
+{
+	const uint8_t *mPos, *mEnd;
+	TArray<FString> &mKeys;
+
+	bool VarInt(uint64_t &v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64 && mPos < mEnd; shift += 7)
+		{
+			uint8_t b = *mPos++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	bool Chars(const char *&k, size_t &len)
+	{
+		uint64_t l;
+		if (!VarInt(l) || l > uint64_t(mEnd - mPos)) return false;
+		k = (const char *)mPos;
+		len = (size_t)l;
+		mPos += len;
+		return true;
+	}
+
+public:
+	FBinaryReader(const char *buffer, size_t length, TArray<FString> &keys)
+		: mPos((const uint8_t*)buffer), mEnd((const uint8_t*)buffer + length), mKeys(keys)
+	{
+	}
+
+	bool operator()(rapidjson::Document &handler)
+	{
+		// Element counts of all open objects and arrays. Objects count their keys, arrays their values.
+		// The document pops two entries per counted key when closing an object, so keys and values
+		// must strictly alternate there or a broken stream would corrupt its stack.
+		TArray<rapidjson::SizeType> counts;
+		TArray<bool> inObject;
+		TArray<bool> expectValue;
+
+		do
+		{
+			if (mPos >= mEnd) return false;
+
+			uint8_t tag = *mPos++;
+			uint64_t v;
+			const char *k;
+			size_t len;
+
+			if (tag != BT_Key && tag != BT_NewKey && tag != BT_EndObject && tag != BT_EndArray && inObject.Size() > 0)
+			{
+				if (!inObject.Last()) counts.Last()++;
+				else if (!expectValue.Last()) return false;	// a value without a key
+				expectValue.Last() = false;
+			}
+
+			switch (tag)
+			{
+			case BT_Null:
+				handler.Null();
+				break;
+
+			case BT_False:
+			case BT_True:
+				handler.Bool(tag == BT_True);
+				break;
+
+			case BT_Int:
+				if (!VarInt(v)) return false;
+				handler.Uint64(v);
+				break;
+
+			case BT_NegInt:
+				if (!VarInt(v)) return false;
+				handler.Int64(int64_t(~v));
+				break;
+
+			case BT_Double:
+			{
+				if (mEnd - mPos < 8) return false;
+				uint64_t bits = 0;
+				for (int i = 7; i >= 0; i--) bits = (bits << 8) | mPos[i];
+				mPos += 8;
+				double d;
+				memcpy(&d, &bits, sizeof(d));
+				handler.Double(d);
+				break;
+			}
+
+			case BT_String:
+				if (!Chars(k, len)) return false;
+				handler.String(k, (rapidjson::SizeType)len, true);
+				break;
+
+			case BT_NewKey:
+				if (!Chars(k, len)) return false;
+				mKeys.Push(FString(k, len));
+				v = mKeys.Size() - 1;
+				// fall through
+			case BT_Key:
+				if (tag == BT_Key && (!VarInt(v) || v >= mKeys.Size())) return false;
+				if (inObject.Size() == 0 || !inObject.Last() || expectValue.Last()) return false;
+				// The key table outlives the document so the names need not be copied.
+				handler.Key(mKeys[(unsigned)v].GetChars(), (rapidjson::SizeType)mKeys[(unsigned)v].Len(), false);
+				counts.Last()++;
+				expectValue.Last() = true;
+				break;
+
+			case BT_StartObject:
+			case BT_StartArray:
+				if (tag == BT_StartObject) handler.StartObject();
+				else handler.StartArray();
+				counts.Push(0);
+				inObject.Push(tag == BT_StartObject);
+				expectValue.Push(false);
+				break;
+
+			case BT_EndObject:
+			case BT_EndArray:
+				if (inObject.Size() == 0 || inObject.Last() != (tag == BT_EndObject) || expectValue.Last()) return false;
+				if (tag == BT_EndObject) handler.EndObject(counts.Last());
+				else handler.EndArray(counts.Last());
+				counts.Pop();
+				inObject.Pop();
+				expectValue.Pop();
+				break;
+
+			default:
+				return false;
+			}
+		} while (inObject.Size() > 0);
+		return mPos == mEnd;
+	}
+};
+
 //==========================================================================
 //
 // some wrapper stuff to keep the RapidJSON dependencies out of the global headers.
@@ -151,23 +452,26 @@ struct FWriter
 	typedef rapidjson::Writer<rapidjson::StringBuffer, rapidjson::UTF8<> > Writer;
 	typedef rapidjson::PrettyWriter<rapidjson::StringBuffer, rapidjson::UTF8<> > PrettyWriter;
 
-	Writer *mWriter1;
-	PrettyWriter *mWriter2;
+	Writer *mWriter1 = nullptr;
+	PrettyWriter *mWriter2 = nullptr;
+	FBinaryWriter *mWriter3 = nullptr;
 	TArray<bool> mInObject;
 	rapidjson::StringBuffer mOutString;
 	TArray<DObject *> mDObjects;
 	TMap<DObject *, int> mObjectMap;
 	
-	FWriter(bool pretty)
+	FWriter(bool pretty, bool binary = false)
 	{
-		if (!pretty)
+		if (binary)
+		{
+			mWriter3 = new FBinaryWriter;
+		}
+		else if (!pretty)
 		{
 			mWriter1 = new Writer(mOutString);
-			mWriter2 = nullptr;
 		}
 		else
 		{
-			mWriter1 = nullptr;
 			mWriter2 = new PrettyWriter(mOutString);
 		}
 	}
@@ -176,6 +480,19 @@ struct FWriter
 	{
 		if (mWriter1) delete mWriter1;
 		if (mWriter2) delete mWriter2;
+		if (mWriter3) delete mWriter3;
+	}
+
+	const char *GetData()
+	{
+		if (mWriter3) return (const char *)mWriter3->mBuffer.Data();
+		return mOutString.GetString();
+	}
+
+	size_t GetSize()
+	{
+		if (mWriter3) return mWriter3->mBuffer.Size();
+		return mOutString.GetSize();
 	}
 
 
@@ -188,36 +505,42 @@ struct FWriter
 	{
 		if (mWriter1) mWriter1->StartObject();
 		else if (mWriter2) mWriter2->StartObject();
+		else if (mWriter3) mWriter3->StartObject();
 	}
 
 	void EndObject()
 	{
 		if (mWriter1) mWriter1->EndObject();
 		else if (mWriter2) mWriter2->EndObject();
+		else if (mWriter3) mWriter3->EndObject();
 	}
 
 	void StartArray()
 	{
 		if (mWriter1) mWriter1->StartArray();
 		else if (mWriter2) mWriter2->StartArray();
+		else if (mWriter3) mWriter3->StartArray();
 	}
 
 	void EndArray()
 	{
 		if (mWriter1) mWriter1->EndArray();
 		else if (mWriter2) mWriter2->EndArray();
+		else if (mWriter3) mWriter3->EndArray();
 	}
 
 	void Key(const char *k)
 	{
 		if (mWriter1) mWriter1->Key(k);
 		else if (mWriter2) mWriter2->Key(k);
+		else if (mWriter3) mWriter3->Key(k);
 	}
 
 	void Null()
 	{
 		if (mWriter1) mWriter1->Null();
 		else if (mWriter2) mWriter2->Null();
+		else if (mWriter3) mWriter3->Null();
 	}
 
 	void StringU(const char *k, bool encode)
@@ -225,6 +548,7 @@ struct FWriter
 		if (encode) k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void String(const char *k)
@@ -232,6 +556,7 @@ struct FWriter
 		k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void String(const char *k, int size)
@@ -239,36 +564,42 @@ struct FWriter
 		k = StringToUnicode(k, size);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void Bool(bool k)
 	{
 		if (mWriter1) mWriter1->Bool(k);
 		else if (mWriter2) mWriter2->Bool(k);
+		else if (mWriter3) mWriter3->Bool(k);
 	}
 
 	void Int(int32_t k)
 	{
 		if (mWriter1) mWriter1->Int(k);
 		else if (mWriter2) mWriter2->Int(k);
+		else if (mWriter3) mWriter3->Int64(k);
 	}
 
 	void Int64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Int64(k);
 		else if (mWriter2) mWriter2->Int64(k);
+		else if (mWriter3) mWriter3->Int64(k);
 	}
 
 	void Uint(uint32_t k)
 	{
 		if (mWriter1) mWriter1->Uint(k);
 		else if (mWriter2) mWriter2->Uint(k);
+		else if (mWriter3) mWriter3->Uint64(k);
 	}
 
 	void Uint64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Uint64(k);
 		else if (mWriter2) mWriter2->Uint64(k);
+		else if (mWriter3) mWriter3->Uint64(uint64_t(k));
 	}
 
 	void Double(double k)
@@ -281,6 +612,10 @@ struct FWriter
 		{
 			mWriter2->Double(k);
 		}
+		else if (mWriter3)
+		{
+			mWriter3->Double(k);
+		}
 	}
 
 };
@@ -295,13 +630,22 @@ struct FReader
 {
 	TArray<FJSONObject> mObjects;
 	rapidjson::Document mDoc;
+	TArray<FString> mKeys;		// for binary input
 	TArray<DObject *> mDObjects;
 	rapidjson::Value *mKeyValue = nullptr;
 	bool mObjectsRead = false;
 
 	FReader(const char *buffer, size_t length)
 	{
-		mDoc.Parse(buffer, length);
+		if (length >= sizeof(BinaryMagic) && !memcmp(buffer, BinaryMagic, sizeof(BinaryMagic)))
+		{
+			FBinaryReader reader(buffer + sizeof(BinaryMagic), length - sizeof(BinaryMagic), mKeys);
+			mDoc.Populate(reader);
+		}
+		else
+		{
+			mDoc.Parse(buffer, length);
+		}
 		mObjects.Push(FJSONObject(&mDoc));
 	}
 
@@ -351,6 +695,23 @@ bool FSerializer::OpenWriter(bool pretty)
 	return true;
 }
 
+//==========================================================================
+//
+// The binary format is a lot faster and smaller than JSON but cannot be
+// read by anything but the engine itself.
+//
+//==========================================================================
+
+bool FSerializer::OpenBinaryWriter()
+{
+	if (w != nullptr || r != nullptr) return false;
+
+	mErrors = 0;
+	w = new FWriter(false, true);
+	BeginObject(nullptr);
+	return true;
+}
+
 //==========================================================================
 //
 //
@@ -1028,9 +1389,9 @@ const char *FSerializer::GetOutput(unsigned *len)
 	EndObject();
 	if (len != nullptr)
 	{
-		*len = (unsigned)w->mOutString.GetSize();
+		*len = (unsigned)w->GetSize();
 	}
-	return w->mOutString.GetString();
+	return w->GetData();
 }
 
 //==========================================================================
@@ -1040,21 +1401,51 @@ const char *FSerializer::GetOutput(unsigned *len)
 //==========================================================================
 
 FCompressedBuffer FSerializer::GetCompressedOutput()
+{
+	FCompressedBuffer buff = GetStoredOutput();
+	CompressBuffer(buff);
+	return buff;
+}
+
+//==========================================================================
+//
+// Returns a copy of the output that still needs to be compressed.
+// This allows compressing it elsewhere, e.g. on a worker thread.
+//
+//==========================================================================
+
+FCompressedBuffer FSerializer::GetStoredOutput()
 {
 	if (isReading()) return{ 0,0,0,0,0,nullptr };
 	FCompressedBuffer buff;
 	WriteObjects();
 	EndObject();
-	buff.mSize = (unsigned)w->mOutString.GetSize();
+	buff.mSize = buff.mCompressedSize = (unsigned)w->GetSize();
+	buff.mMethod = METHOD_STORED;
 	buff.mZipFlags = 0;
-	buff.mCRC32 = crc32(0, (const Bytef*)w->mOutString.GetString(), buff.mSize);
+	buff.mCRC32 = crc32(0, (const Bytef*)w->GetData(), buff.mSize);
+	buff.mBuffer = new char[buff.mSize + 1];
+	memcpy(buff.mBuffer, w->GetData(), buff.mSize);
+	return buff;
+}
+
+//==========================================================================
+//
+// Deflates a stored buffer in place. This does not depend on any
+// serializer state so it may be called from any thread.
+//
+//==========================================================================
+
+bool CompressBuffer(FCompressedBuffer &buff)
+{
+	if (buff.mMethod != METHOD_STORED || buff.mBuffer == nullptr) return false;
 
 	uint8_t *compressbuf = new uint8_t[buff.mSize+1];
 
 	z_stream stream;
 	int err;
 
-	stream.next_in = (Bytef *)w->mOutString.GetString();
+	stream.next_in = (Bytef *)buff.mBuffer;
 	stream.avail_in = buff.mSize;
 	stream.next_out = (Bytef*)compressbuf;
 	stream.avail_out = buff.mSize;
@@ -1075,23 +1466,23 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 		deflateEnd(&stream);
 		goto error;
 	}
-	buff.mCompressedSize = stream.total_out;
 
 	err = deflateEnd(&stream);
 	if (err == Z_OK)
 	{
-		buff.mBuffer = new char[buff.mCompressedSize];
+		delete[] buff.mBuffer;
+		buff.mBuffer = new char[stream.total_out];
+		buff.mCompressedSize = stream.total_out;
 		buff.mMethod = METHOD_DEFLATE;
 		memcpy(buff.mBuffer, compressbuf, buff.mCompressedSize);
 		delete[] compressbuf;
-		return buff;
+		return true;
 	}
 
 error:
-	memcpy(compressbuf, w->mOutString.GetString(), buff.mSize + 1);
-	buff.mCompressedSize = buff.mSize;
-	buff.mMethod = METHOD_STORED;
-	return buff;
+	// leave the buffer stored.
+	delete[] compressbuf;
+	return false;
 }
 
 //==========================================================================
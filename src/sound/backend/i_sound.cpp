@@ -246,7 +246,7 @@ void I_InitSound ()
 {
 	FModule_SetProgDir(progdir);
 	/* Get command line options: */
-	nosound = !!Args->CheckParm ("-nosound");
+	nosound = !!Args->CheckParm ("-nosound") || !!Args->CheckParm ("-benchmark");
 	nosfx = !!Args->CheckParm ("-nosfx");
 
 	GSnd = NULL;
@@ -168,6 +168,11 @@ public:
 	static void StaticWriteRNGState (FSerializer &file);
 	static FRandom *StaticFindRNG(const char *name);
 
+	// RNGs are identified by their name's CRC, e.g. in save games and the script cache.
+	static FRandom *StaticFirstRNG() { return RNGList; }
+	FRandom *GetNext() const { return Next; }
+	uint32_t GetNameCRC() const { return NameCRC; }
+
 #ifndef NDEBUG
 	static void StaticPrintSeeds ();
 #endif
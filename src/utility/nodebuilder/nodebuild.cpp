@@ -43,6 +43,7 @@
 
 #include "doomdata.h"
 #include "nodebuild.h"
+#include "ctpl.h"
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
@@ -444,6 +445,7 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	int bestvalue;
 	uint32_t bestseg;
 	uint32_t seg;
+	unsigned int count;
 	bool nosplitters = false;
 
 	bestvalue = 0;
@@ -451,11 +453,15 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 
 	seg = set;
 	stepleft = 0;
+	count = 0;
 
 	memset (&PlaneChecked[0], 0, PlaneChecked.Size());
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
+	// Which segs get tested does not depend on any of the scores, so they
+	// are collected first and then scored all at once.
+	SplitCandidates.Clear();
 	while (seg != UINT_MAX)
 	{
 		FPrivSeg *pseg = &Segs[seg];
@@ -473,31 +479,42 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
-
-				int value = Heuristic (node, set, nosplit);
-
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
-
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
+				SplitCandidates.Push (seg);
 			}
 		}
 
 		seg = pseg->next;
+		count++;
+	}
+
+	ScoreSplitters (set, count, nosplit);
+
+	for (unsigned int i = 0; i < SplitCandidates.Size(); ++i)
+	{
+		int value = SplitScores[i];
+
+		seg = SplitCandidates[i];
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d scores %d\n", seg, Segs[seg].linedef, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = seg;
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
 	}
 
 	if (bestseg == UINT_MAX)
 	{ // No lines split any others into two sets, so this is a convex region.
 	D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
+		// Leave the node as the last candidate set it, like the serial search did.
+		if (SplitCandidates.Size() > 0)
+		{
+			SetNodeFromSeg (node, &Segs[SplitCandidates.Last()]);
+		}
 		return nosplitters ? -1 : 0;
 	}
 
@@ -508,13 +525,79 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	return 1;
 }
 
+// Runs Heuristic for every seg in SplitCandidates. Scoring a splitter only
+// reads the segs and vertices, so for big sets the candidates are spread over
+// a thread pool. Each score ends up in the same slot the serial loop would
+// have put it in, so the chosen splitter and thus the tree never change.
+
+static ctpl::thread_pool SplitterPool;
+
+struct FSplitterScratch
+{
+	TArray<int> Touched;
+	TArray<int> Colinear;
+};
+static TArray<FSplitterScratch> SplitterScratch;
+
+void FNodeBuilder::ScoreSplitters (uint32_t set, unsigned int count, bool honorNoSplit)
+{
+	// Each candidate classifies every seg in the set, so this is roughly
+	// the number of ClassifyLine calls needed. Below it threading costs more
+	// than it saves, which is the case for everything but the top of the tree.
+	const unsigned int MIN_THREADED_WORK = 32768;
+	const unsigned int numcands = SplitCandidates.Size();
+
+	SplitScores.Resize (numcands);
+
+	if (numcands < 2 || numcands * count < MIN_THREADED_WORK || std::thread::hardware_concurrency() < 2)
+	{
+		for (unsigned int i = 0; i < numcands; ++i)
+		{
+			node_t node;
+			SetNodeFromSeg (node, &Segs[SplitCandidates[i]]);
+			SplitScores[i] = Heuristic (node, set, honorNoSplit);
+		}
+		return;
+	}
+
+	if (SplitterPool.size() == 0)
+	{
+		SplitterPool.resize (clamp<int>(std::thread::hardware_concurrency() - 1, 1, 15));
+		SplitterScratch.Resize (SplitterPool.size() + 1);
+	}
+
+	// The calling thread takes the last slice itself.
+	const unsigned int numslices = MIN<unsigned int>(SplitterPool.size() + 1, numcands);
+	const unsigned int slicesize = (numcands + numslices - 1) / numslices;
+	auto scoreSlice = [&](unsigned int slice)
+	{
+		FSplitterScratch &scratch = SplitterScratch[slice];
+		unsigned int start = slice * slicesize;
+		unsigned int end = MIN(start + slicesize, numcands);
+		for (unsigned int i = start; i < end; ++i)
+		{
+			node_t node;
+			SetNodeFromSeg (node, &Segs[SplitCandidates[i]]);
+			SplitScores[i] = Heuristic (node, set, honorNoSplit, scratch.Touched, scratch.Colinear);
+		}
+	};
+
+	std::vector<std::future<void>> jobs;
+	for (unsigned int slice = 0; slice < numslices - 1; ++slice)
+	{
+		jobs.push_back (SplitterPool.push ([&, slice](int) { scoreSlice (slice); }));
+	}
+	scoreSlice (numslices - 1);
+	for (auto &job : jobs) job.wait();
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
 // true. A score of 0 means that the splitter does not split any of the segs
 // in the set.
 
-int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -529,8 +612,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != UINT_MAX)
 	{
@@ -556,32 +639,32 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -698,8 +781,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -712,10 +795,10 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}
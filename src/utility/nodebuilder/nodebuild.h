@@ -271,6 +271,9 @@ private:
 
 	TArray<FSplitSharer> SplitSharers;	// Segs colinear with the current splitter
 
+	TArray<uint32_t> SplitCandidates;	// Segs SelectSplitter wants scored
+	TArray<int> SplitScores;			// Heuristic results for SplitCandidates
+
 	uint32_t HackSeg;			// Seg to force to back of splitter
 	uint32_t HackMate;			// Seg to use in front of hack seg
 	FLevel &Level;
@@ -297,7 +300,9 @@ private:
 	bool ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uint32_t mate);	int SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg, int step, bool nosplit);
 	void SplitSegs (uint32_t set, node_t &node, uint32_t splitseg, uint32_t &outset0, uint32_t &outset1, unsigned int &count0, unsigned int &count1);
 	uint32_t SplitSeg (uint32_t segnum, int splitvert, int v1InFront);
-	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit);
+	void ScoreSplitters (uint32_t set, unsigned int count, bool honorNoSplit);
+	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit) { return Heuristic (node, set, honorNoSplit, Touched, Colinear); }
+	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear);
 
 	// Returns:
 	//	0 = seg is in front